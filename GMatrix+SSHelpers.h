@@ -0,0 +1,33 @@
+#ifndef SSMatrixHelpers_DEFINED
+#define SSMatrixHelpers_DEFINED
+
+#include "include/GMatrix.h"
+#include "include/GRect.h"
+
+/// True if the matrix only scales and translates, so axis-aligned rects stay axis-aligned
+static inline bool GMatrix_isScaleTranslate(const GMatrix& matrix) {
+    return matrix[1] == 0 && matrix[2] == 0;
+}
+
+/// Map the rect's corners, returning their bounds. Exact when GMatrix_isScaleTranslate, and
+/// otherwise still contains everything inside the rect once mapped.
+static inline GRect GMatrix_mapRect(const GMatrix& matrix, const GRect& rect) {
+    GPoint corners[4] = {
+        { rect.left, rect.top }, { rect.right, rect.top },
+        { rect.right, rect.bottom }, { rect.left, rect.bottom }
+    };
+    matrix.mapPoints(corners, 4);
+
+    GRect bounds = GRect::LTRB(corners[0].x, corners[0].y, corners[0].x, corners[0].y);
+
+    for (int i = 1; i < 4; i++) {
+        bounds.left = std::min(bounds.left, corners[i].x);
+        bounds.top = std::min(bounds.top, corners[i].y);
+        bounds.right = std::max(bounds.right, corners[i].x);
+        bounds.bottom = std::max(bounds.bottom, corners[i].y);
+    }
+
+    return bounds;
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "include/GMatrix.h"
+#include "SSStats.h"
 
 /// Initializes an identity matrix
 GMatrix::GMatrix() : GMatrix(
@@ -48,6 +49,8 @@ GMatrix GMatrix::Concat(const GMatrix& a, const GMatrix& b) {
 
 /// If the inverse exists, return it, else return {} to signal no return value.
 nonstd::optional<GMatrix> GMatrix::invert() const {
+    SS_STAT_ADD(matrixInversions, 1);
+
     // Find determinant (ad - bc)
     float determinant = fMat[0] * fMat[3] - fMat[1] * fMat[2];
 
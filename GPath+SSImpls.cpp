@@ -104,10 +104,10 @@ void updateBoundsFromCubic(GRect& bounds, const GPoint points[]) {
     }
 }
 
-/// Return the bounds of all of the control-points in the path.
+/// The bounds of all of the control-points in the path, cached by the constructor for bounds().
 ///
 /// If there are no points, returns an empty rect (all zeros)
-GRect GPath::bounds() const {
+GRect GPath::computeBounds() const {
     // Return empty rect if there are no points
     if (fPts.empty()) return GRect();
 
@@ -142,6 +142,82 @@ GRect GPath::bounds() const {
     return bounds;
 }
 
+/// Sign of the cross product of two edge vectors: which way the contour turns between them
+static int turnDirection(GVector a, GVector b) {
+    float cross = a.x * b.y - a.y * b.x;
+    return (cross > 0) - (cross < 0);
+}
+
+/// Classify the path for shape(), cached by the constructor. Only looks at a single contour of
+/// lines; kOval can't be recognized from the points and is passed in by GPathBuilder instead.
+GPathShape GPath::computeShape() const {
+    // A single contour: a move followed only by lines
+    if (fVbs.size() < 3 || fVbs[0] != GPathVerb::kMove) return GPathShape::kGeneral;
+
+    for (size_t i = 1; i < fVbs.size(); i++) {
+        if (fVbs[i] != GPathVerb::kLine) return GPathShape::kGeneral;
+    }
+
+    // Points, leaving out the closing point if it repeats the first
+    int count = static_cast<int>(fPts.size());
+    if (fPts[count - 1] == fPts[0]) count -= 1;
+
+    // A rectangle has 4 corners, each edge moves along exactly one axis, and the axes alternate
+    if (count == 4) {
+        bool isRect = true;
+
+        for (int i = 0; i < 4; i++) {
+            GVector edge = fPts[(i + 1) % 4] - fPts[i];
+            GVector nextEdge = fPts[(i + 2) % 4] - fPts[(i + 1) % 4];
+            if ((edge.x == 0) == (edge.y == 0) || (edge.x == 0) == (nextEdge.x == 0)) isRect = false;
+        }
+
+        if (isRect) return GPathShape::kRect;
+    }
+
+    // A convex contour always turns the same way, and winds around once: its edges' x and y
+    // directions each flip at most twice
+    int direction = 0;
+    int xFlips = 0, yFlips = 0;
+    int xSign = 0, ySign = 0;
+    GVector previous = { 0, 0 };
+
+    for (int i = 0; i <= count; i++) {
+        GVector edge = fPts[(i + 1) % count] - fPts[i % count];
+        if (edge.x == 0 && edge.y == 0) continue;
+
+        int edgeXSign = (edge.x > 0) - (edge.x < 0);
+        int edgeYSign = (edge.y > 0) - (edge.y < 0);
+
+        // The first edge is revisited at the end only to check the turn back into it
+        if (i < count) {
+            if (edgeXSign != 0) {
+                if (xSign != 0 && edgeXSign != xSign) xFlips++;
+                xSign = edgeXSign;
+            }
+
+            if (edgeYSign != 0) {
+                if (ySign != 0 && edgeYSign != ySign) yFlips++;
+                ySign = edgeYSign;
+            }
+        }
+
+        if (previous.x != 0 || previous.y != 0) {
+            int turn = turnDirection(previous, edge);
+
+            if (turn != 0) {
+                if (direction != 0 && turn != direction) return GPathShape::kGeneral;
+                direction = turn;
+            }
+        }
+
+        previous = edge;
+    }
+
+    if (direction == 0 || xFlips > 2 || yFlips > 2) return GPathShape::kGeneral;
+    return GPathShape::kConvex;
+}
+
 /// Given 0 < t < 1, subdivide the src[] quadratic bezier at t into two new quadratics in dst[]
 /// such that
 /// 0...t is stored in dst[0..2]
@@ -46,6 +46,9 @@ void GPathBuilder::addPolygon(const GPoint pts[], int count) {
 void GPathBuilder::addCircle(GPoint center, float radius, GPathDirection direction) {
     /// TODO: Test this
 
+    // The path is a plain oval as long as nothing came before the circle
+    const bool isOnlyContour = fVbs.empty();
+
     // Create points along unit circle
     const int numPoints = 13;
     float k = (4.0f* sqrt(2.0f) - 4.0f) / 3.0f;
@@ -98,4 +101,6 @@ void GPathBuilder::addCircle(GPoint center, float radius, GPathDirection directi
         break;
     }
     }
-}
\ No newline at end of file
+
+    fIsOval = isOnlyContour;
+}
@@ -0,0 +1,79 @@
+#include "SSArena.h"
+
+/// Smallest block the arena adds, so that small draws share one block
+static constexpr size_t kMinimumBlockSize = 64 * 1024;
+
+/// Bytes an allocation of the given size takes up, keeping the next one aligned
+static size_t alignedSize(size_t bytes) {
+    return (std::max<size_t>(bytes, 1) + SSArena::kAlignment - 1) & ~(SSArena::kAlignment - 1);
+}
+
+void* SSArena::allocateBytes(size_t bytes) {
+    bytes = alignedSize(bytes);
+
+    if (blocks.empty() || currentOffset + bytes > blocks[currentBlock].size) {
+        nextBlock(bytes);
+    }
+
+    char* allocation = blocks[currentBlock].memory.get() + currentOffset;
+    currentOffset += bytes;
+    used += bytes;
+    highWater = std::max(highWater, used);
+
+    return allocation;
+}
+
+void* SSArena::growBytes(void* allocation, size_t bytes, size_t newBytes) {
+    bytes = alignedSize(bytes);
+    newBytes = alignedSize(newBytes);
+
+    // Grow in place if allocation is the last thing in the current block and there is room
+    char* top = blocks[currentBlock].memory.get() + currentOffset;
+    bool isLast = static_cast<char*>(allocation) + bytes == top;
+
+    if (isLast && currentOffset - bytes + newBytes <= blocks[currentBlock].size) {
+        currentOffset = currentOffset - bytes + newBytes;
+        used = used - bytes + newBytes;
+        highWater = std::max(highWater, used);
+        return allocation;
+    }
+
+    void* moved = allocateBytes(newBytes);
+    memcpy(moved, allocation, std::min(bytes, newBytes));
+    return moved;
+}
+
+void SSArena::nextBlock(size_t bytes) {
+    size_t lastSize = 0;
+
+    if (!blocks.empty()) {
+        // The rest of the current block goes unused until the arena is rewound
+        used += blocks[currentBlock].size - currentOffset;
+        lastSize = blocks[currentBlock].size;
+        currentBlock += 1;
+    }
+
+    currentOffset = 0;
+
+    // Reuse the next block if it is big enough, otherwise replace it and everything after it
+    if (currentBlock < blocks.size() && blocks[currentBlock].size >= bytes) return;
+
+    blocks.resize(currentBlock);
+
+    size_t size = alignedSize(std::max({ bytes, kMinimumBlockSize, lastSize * 2 }));
+    blocks.push_back({ std::unique_ptr<char, Free>(static_cast<char*>(std::aligned_alloc(kAlignment, size))), size });
+}
+
+void SSArena::rewind(const Marker& marker) {
+    currentBlock = marker.block;
+    currentOffset = marker.offset;
+    used = marker.used;
+
+    // Once nothing is in use, merge the blocks into one that fits the busiest draw so far
+    if (used == 0 && blocks.size() > 1) {
+        size_t size = alignedSize(highWater);
+
+        blocks.clear();
+        blocks.push_back({ std::unique_ptr<char, Free>(static_cast<char*>(std::aligned_alloc(kAlignment, size))), size });
+    }
+}
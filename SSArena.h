@@ -0,0 +1,148 @@
+#ifndef SSArena_DEFINED
+#define SSArena_DEFINED
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/// Bump allocator for scratch memory that only lives as long as one draw call. Allocations are
+/// 64 byte aligned (one cache line) and never freed individually: an SSArenaScope hands back
+/// everything allocated since it was opened.
+///
+/// Memory comes in blocks. When a draw outgrows the current block another one is added, and once
+/// the arena is completely rewound the blocks are merged into one of the high-water size, so
+/// that after the first few draws the arena stops calling malloc altogether.
+class SSArena {
+public:
+    static constexpr size_t kAlignment = 64;
+
+    /// Where the arena was at some point, for rewind()
+    struct Marker {
+        size_t block;
+        size_t offset;
+        size_t used;
+    };
+
+    SSArena() {}
+
+    SSArena(const SSArena&) = delete;
+    SSArena& operator=(const SSArena&) = delete;
+
+    /// Uninitialized room for count Ts. Only for types that don't need their destructor run.
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "SSArena never runs destructors");
+        return static_cast<T*>(allocateBytes(count * sizeof(T)));
+    }
+
+    /// Resize array, the count Ts most recently allocated, to newCount. It grows in place if
+    /// nothing was allocated after it and its block has room; otherwise it is copied.
+    template <typename T>
+    T* grow(T* array, size_t count, size_t newCount) {
+        static_assert(std::is_trivially_copyable<T>::value, "SSArena moves arrays with memcpy");
+        return static_cast<T*>(growBytes(array, count * sizeof(T), newCount * sizeof(T)));
+    }
+
+    Marker mark() const {
+        return { currentBlock, currentOffset, used };
+    }
+
+    /// Release everything allocated since marker was taken.
+    void rewind(const Marker& marker);
+
+    /// Most bytes the arena has had in use at once
+    size_t highWaterMark() const {
+        return highWater;
+    }
+
+private:
+    struct Free {
+        void operator()(char* memory) const { std::free(memory); }
+    };
+
+    struct Block {
+        std::unique_ptr<char, Free> memory;
+        size_t size;
+    };
+
+    void* allocateBytes(size_t bytes);
+    void* growBytes(void* allocation, size_t bytes, size_t newBytes);
+
+    /// Move on to a block with room for bytes, adding one if needed
+    void nextBlock(size_t bytes);
+
+    std::vector<Block> blocks;
+    size_t currentBlock = 0;
+    size_t currentOffset = 0;
+
+    /// Bytes handed out, counting the unused tails of blocks that were moved past
+    size_t used = 0;
+    size_t highWater = 0;
+};
+
+/// Rewinds the arena to where it was when the scope was opened, when the scope closes. Draw calls
+/// open one, so scratch memory never outlives the draw, and nested draws (drawQuad into drawMesh)
+/// stack naturally.
+class SSArenaScope {
+public:
+    SSArenaScope(SSArena& arena) : arena(arena), marker(arena.mark()) {}
+    ~SSArenaScope() { arena.rewind(marker); }
+
+    SSArenaScope(const SSArenaScope&) = delete;
+    SSArenaScope& operator=(const SSArenaScope&) = delete;
+
+private:
+    SSArena& arena;
+    const SSArena::Marker marker;
+};
+
+/// A growable array in an SSArena, for lists whose final size isn't known up front (edges, spans).
+/// Growing is cheap as long as it is the arena's most recent allocation.
+template <typename T>
+class SSArenaArray {
+public:
+    SSArenaArray(SSArena& arena, size_t capacity = 64)
+        : arena(arena)
+        , items(arena.allocate<T>(capacity))
+        , capacity(capacity)
+    {}
+
+    void push_back(const T& item) {
+        if (count == capacity) {
+            items = arena.grow(items, capacity, capacity * 2);
+            capacity *= 2;
+        }
+
+        items[count++] = item;
+    }
+
+    /// Keep only the first newCount items
+    void truncate(size_t newCount) {
+        count = std::min(count, newCount);
+    }
+
+    void clear() { count = 0; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T* data() { return items; }
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+
+    T& operator[](size_t index) { return items[index]; }
+    const T& operator[](size_t index) const { return items[index]; }
+
+private:
+    SSArena& arena;
+    T* items;
+    size_t capacity;
+    size_t count = 0;
+};
+
+#endif // SSArena_DEFINED
@@ -0,0 +1,58 @@
+#include "SSBitmapAlloc.h"
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+
+static size_t roundUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+size_t SSBitmap_rowBytes(int width, bool padRows) {
+    const size_t rowBytes = static_cast<size_t>(width) * sizeof(GPixel);
+
+    // Rows narrower than a line would mostly be padding
+    if (!padRows || rowBytes < kSSCacheLineSize) return rowBytes;
+
+    const size_t padded = roundUp(rowBytes, kSSCacheLineSize);
+    return padded % 1024 == 0 ? padded + kSSCacheLineSize : padded;
+}
+
+bool SSBitmap_alloc(GBitmap* bitmap, int width, int height, const SSAllocOptions& options) {
+    if (width <= 0 || height <= 0) {
+        bitmap->alloc(width, height);
+        return true;
+    }
+
+    const size_t rowBytes = SSBitmap_rowBytes(width, options.padRows);
+    const size_t size = rowBytes * height;
+
+    // aligned_alloc wants the size to be a multiple of the alignment
+    const size_t alignment = size >= kSSHugePageSize ? kSSHugePageSize : kSSCacheLineSize;
+    const size_t allocationSize = roundUp(size, alignment);
+
+    std::shared_ptr<void> storage;
+    bool recycled = false;
+
+    if (options.pool) {
+        storage = options.pool->acquire(allocationSize, alignment, &recycled);
+    } else {
+        storage = std::shared_ptr<void>(aligned_alloc(alignment, allocationSize), free);
+    }
+
+    if (!storage) return false;
+
+#ifdef MADV_HUGEPAGE
+    // Only a hint, before the first touch: the kernel may not have huge pages to give
+    if (alignment == kSSHugePageSize && !recycled) {
+        madvise(storage.get(), allocationSize, MADV_HUGEPAGE);
+    }
+#endif
+
+    if (options.zero) {
+        memset(storage.get(), 0, size);
+    }
+
+    GPixel* pixels = static_cast<GPixel*>(storage.get());
+    bitmap->reset(width, height, rowBytes, pixels, GBitmap::kNo_IsOpaque, std::move(storage));
+    return true;
+}
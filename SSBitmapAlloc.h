@@ -0,0 +1,39 @@
+#ifndef SSBitmapAlloc_DEFINED
+#define SSBitmapAlloc_DEFINED
+
+#include <cstddef>
+#include "include/GBitmap.h"
+#include "SSPixelPool.h"
+
+/// Every allocation starts on a cache line, so rows padded to whole lines never share one
+constexpr size_t kSSCacheLineSize = 64;
+
+/// Allocations at least this big are aligned to it and offered to the kernel as huge pages,
+/// which cuts TLB misses when a large canvas is swept row by row
+constexpr size_t kSSHugePageSize = 2 << 20;
+
+struct SSAllocOptions {
+    /// Clear the pixels to transparent black. Skip it when the caller is about to clear() or
+    /// overwrite every pixel anyway
+    bool zero = true;
+
+    /// Round rowBytes (of rows at least a line wide) up to whole cache lines, plus one more line
+    /// if that leaves rowBytes a multiple of 1K. Rows a multiple of 4K apart land in the same L1
+    /// sets, so at power of two widths, walking down a column evicts itself
+    bool padRows = true;
+
+    /// Where the memory comes from and goes back to, if anywhere. Without a pool, it is freed
+    /// when the bitmap lets go of it
+    SSPixelPool* pool = nullptr;
+};
+
+/// The rowBytes SSBitmap_alloc gives a bitmap width pixels wide
+size_t SSBitmap_rowBytes(int width, bool padRows);
+
+/// Like GBitmap::alloc, but with the base cache line aligned (huge page aligned for big
+/// bitmaps), padded rows, optional zeroing and optional pooling. As with alloc(), the pixels
+/// belong to the bitmap's storage(). Returns false, leaving bitmap untouched, if the memory
+/// can't be allocated.
+bool SSBitmap_alloc(GBitmap* bitmap, int width, int height, const SSAllocOptions& options = {});
+
+#endif // SSBitmapAlloc_DEFINED
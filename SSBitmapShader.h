@@ -5,8 +5,9 @@
 #include "include/GMatrix.h"
 #include "include/GShader.h"
 #include "SSMath.h"
+#include "SSShader.h"
 
-class SSBitmapShader : public GShader {
+class SSBitmapShader : public SSShader {
 public:
     /// Instantatiates an SSBitmapShader with a bitmap and local matrix.
     SSBitmapShader(const GBitmap bitmap, const GMatrix localMatrix, GTileMode tileMode) 
@@ -21,7 +22,13 @@ public:
         , tileMode(tileMode)
     {
         auto inverse = localMatrix.invert();
-        if (inverse) this->inverseMatrix = inverse.value();
+
+        if (inverse) {
+            this->localInverseMatrix = inverse.value();
+            this->inverseMatrix = inverse.value();
+        }
+
+        this->localMatrixIsInvertible = inverse.has_value();
     }
 
     /// Return true iff all of the GPixels that may be returned by this shader will be opaque.
@@ -41,6 +48,14 @@ public:
         }
     }
 
+    /// Skips inverting the CTM: (ctm * localMatrix)^-1 == localMatrix^-1 * ctm^-1.
+    bool setInverseContext(const GMatrix& inverseCTM) override {
+        if (!localMatrixIsInvertible) return false;
+
+        this->inverseMatrix = localInverseMatrix * inverseCTM;
+        return true;
+    }
+
     /// Given a row of pixels in device space [x, y] ... [x + count - 1, y], return the
     /// corresponding src pixels in row[0...count - 1]. The caller must ensure that row[]
     /// can hold at least [count] entries.
@@ -67,6 +82,11 @@ public:
         }
     }
 
+    /// Contribute a single sample stage, which shades each chunk without a virtual call.
+    void appendStages(SSPipeline& pipeline) override {
+        pipeline.append(sampleStage, this);
+    }
+
 private:
     const GBitmap bitmap;
     const GMatrix localMatrix;
@@ -78,8 +98,15 @@ private:
     const float fInverseHeight;
     const GTileMode tileMode;
 
+    GMatrix localInverseMatrix;
+    bool localMatrixIsInvertible;
     GMatrix inverseMatrix;
 
+    static void sampleStage(SSPipelineRegisters& registers, void* context) {
+        SSBitmapShader* shader = static_cast<SSBitmapShader*>(context);
+        shader->SSBitmapShader::shadeRow(registers.x, registers.y, registers.count, registers.src);
+    }
+
     static float repeat(const float& x, const float& scaleUpAmount, const float& scaleDownAmount) {
         if (x >= 0.0f && x <= scaleUpAmount) {
             return x;
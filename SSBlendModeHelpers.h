@@ -6,6 +6,7 @@
 #include "include/GBlendMode.h"
 #include "include/GColor.h"
 #include "SSMath.h"
+#include "SSPremul.h"
 
 // MARK: Premultiplication
 
@@ -28,13 +29,16 @@ static inline GPixel colorToPixelOpaque(const GColor& color) {
 }
 
 static inline GColor pixelToColor(const GPixel& pixel) {
-    float a = (float) GPixel_GetA(pixel) / 255.0f;
-    if (a == 0) return GColor::RGBA(0, 0, 0, 0);
+    const int alpha = GPixel_GetA(pixel);
+    if (alpha == 0) return GColor::RGBA(0, 0, 0, 0);
 
-    float r = ((float) GPixel_GetR(pixel) / 255.0f) / a;
-    float g = ((float) GPixel_GetG(pixel) / 255.0f) / a;
-    float b = ((float) GPixel_GetB(pixel) / 255.0f) / a;
-    return GColor::RGBA(r, g, b, a);
+    // (c / 255) / (alpha / 255) == c / alpha, and 1 / alpha comes from a table
+    const float reciprocal = kSSPremulTables.unpremulReciprocal[alpha];
+
+    float r = (float) GPixel_GetR(pixel) * reciprocal;
+    float g = (float) GPixel_GetG(pixel) * reciprocal;
+    float b = (float) GPixel_GetB(pixel) * reciprocal;
+    return GColor::RGBA(r, g, b, (float) alpha * (1.0f / 255));
 }
 
 // MARK: Blend Modes
@@ -180,9 +184,67 @@ static inline auto blendModulate = [](GPixel src, GPixel* dst) {
     return GPixel_PackARGB(a, r, g, b);
 };
 
+/// MARK: Coverage
+
+/// Partially apply a blend: dst + (blended - dst) * coverage / 255, component by component.
+/// This is how anti-aliased edges blend, whatever the blend mode.
+static inline GPixel lerpPixel(GPixel dst, GPixel blended, unsigned coverage) {
+    auto lerp = [coverage](unsigned dst, unsigned blended) {
+        return divBy255(blended * coverage + dst * (255 - coverage));
+    };
+
+    unsigned r = lerp(GPixel_GetR(dst), GPixel_GetR(blended));
+    unsigned g = lerp(GPixel_GetG(dst), GPixel_GetG(blended));
+    unsigned b = lerp(GPixel_GetB(dst), GPixel_GetB(blended));
+    unsigned a = lerp(GPixel_GetA(dst), GPixel_GetA(blended));
+
+    return GPixel_PackARGB(a, r, g, b);
+}
+
 /// MARK: Blend Mode Simplification
 
-static inline GBlendMode simplifyBlendMode(GBlendMode original, bool isOpaque, bool isTransparent) {
+/// The blend mode that does the same to an opaque destination (Da == 1) with less work. Each one
+/// is exact in 8 bits: with dst alpha 255, divBy255 of the dropped terms is 0 or passes src
+/// through unchanged.
+static inline GBlendMode simplifyBlendModeForOpaqueDst(GBlendMode original) {
+    switch (original) {
+        // S * (1 - Da) + D == D
+        case GBlendMode::kDstOver: return GBlendMode::kDst;
+        // S * Da == S
+        case GBlendMode::kSrcIn: return GBlendMode::kSrc;
+        // S * (1 - Da) == 0
+        case GBlendMode::kSrcOut: return GBlendMode::kClear;
+        // S * Da + D * (1 - Sa) == S + D * (1 - Sa)
+        case GBlendMode::kSrcATop: return GBlendMode::kSrcOver;
+        // D * Sa + S * (1 - Da) == D * Sa
+        case GBlendMode::kDstATop: return GBlendMode::kDstIn;
+        // S * (1 - Da) + D * (1 - Sa) == D * (1 - Sa)
+        case GBlendMode::kXor: return GBlendMode::kDstOut;
+        default: return original;
+    }
+}
+
+/// Whether an opaque destination stays opaque when blended with mode (already simplified)
+static inline bool blendModeKeepsDstOpaque(GBlendMode mode, bool srcIsOpaque) {
+    switch (mode) {
+        // Da' == Da, and Sa + (1 - Sa) * Da == 1
+        case GBlendMode::kDst:
+        case GBlendMode::kSrcOver:
+            return true;
+        // Da' == Sa
+        case GBlendMode::kSrc:
+        case GBlendMode::kDstIn:
+            return srcIsOpaque;
+        default:
+            return false;
+    }
+}
+
+static inline GBlendMode simplifyBlendMode(GBlendMode original, bool isOpaque, bool isTransparent, bool dstIsOpaque = false) {
+    if (dstIsOpaque) {
+        original = simplifyBlendModeForOpaqueDst(original);
+    }
+
     // src simplification
     if (original == GBlendMode::kSrc) {
         // if (src.a == 0) {
@@ -0,0 +1,10 @@
+#include "SSCanvas.h"
+#include "SSBlendModeHelpers.h"
+
+/// Simplify a draw's blend mode for its source and the destination, tracking dstIsOpaque.
+GBlendMode SSCanvas::simplifyBlendModeForDraw(GBlendMode blendMode, bool srcIsOpaque, bool srcIsTransparent) {
+    const GBlendMode simplified = simplifyBlendMode(blendMode, srcIsOpaque, srcIsTransparent, dstIsOpaque);
+
+    dstIsOpaque = dstIsOpaque && blendModeKeepsDstOpaque(simplified, srcIsOpaque);
+    return simplified;
+}
@@ -3,6 +3,8 @@
 
 /// Fill the entire canvas with the specified color, using SRC porter-duff mode.
 void SSCanvas::clear(const GColor& color) {
+    SS_STATS_DRAW(stats, SSDrawType::kClear);
+
     // Premultiply color
     GPixel new_pixel = colorToPixel(color);
 
@@ -18,4 +20,11 @@ void SSCanvas::clear(const GColor& color) {
             row[x] = new_pixel;
         }
     }
+
+    dstIsOpaque = color.a >= 1;
+
+    // In kF32, clear the float pixels too, to the unrounded color
+    if (!f32Pixels.empty()) {
+        std::fill(f32Pixels.begin(), f32Pixels.end(), SSPixelF32_fromColor(color));
+    }
 }
\ No newline at end of file
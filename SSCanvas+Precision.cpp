@@ -0,0 +1,22 @@
+#include "SSCanvas.h"
+
+/// Switch precision modes, copying the bitmap into the float buffer when entering kF32.
+void SSCanvas::setPrecision(SSPrecision precision) {
+    if (precision == SSPrecision::k8888) {
+        std::vector<SSPixelF32>().swap(f32Pixels);
+        return;
+    }
+
+    const int width = bitmap.width();
+    const int height = bitmap.height();
+    f32Pixels.resize(static_cast<size_t>(width) * height);
+
+    for (int y = 0; y < height; y++) {
+        const GPixel *row = bitmap.getAddr(0, y);
+        SSPixelF32 *f32Row = f32Pixels.data() + static_cast<size_t>(y) * width;
+
+        for (int x = 0; x < width; x++) {
+            f32Row[x] = SSPixelF32_fromPixel(row[x]);
+        }
+    }
+}
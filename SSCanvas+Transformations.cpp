@@ -1,7 +1,7 @@
 #include "SSCanvas.h"
 
 /// Get the current transformation matrix from the top of the stack.
-GMatrix SSCanvas::getCTM() {
+GMatrix SSCanvas::getCTM() const {
     if (matrices.empty()) {
         exit(-1);
     } else {
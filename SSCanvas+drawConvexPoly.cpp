@@ -1,6 +1,7 @@
 #include "SSCanvas.h"
 #include "SSBlendModeHelpers.h"
 #include "SSEdge.h"
+#include "SSSpanBlitter.h"
 
 void findIntersections(int& left, int& right, int y, SSEdge edge0, SSEdge edge1) {
     // Find edges intersections with ray
@@ -12,28 +13,28 @@ void findIntersections(int& left, int& right, int y, SSEdge edge0, SSEdge edge1)
     right = std::max(leftIntersection, rightIntersection);
 }
 
-void advanceEdgeIfExpiring(SSEdge& edge, int& next, const int& y, const std::vector<SSEdge>& edges) {
-     if (y + 1 >= edge.bottom) {
+void advanceEdgeIfExpiring(SSEdge& edge, int& next, const int& y, const SSArenaArray<SSEdge>& edges) {
+     if (y + 1 >= edge.bottom && next < static_cast<int>(edges.size())) {
         edge = edges[next];
         next += 1;
     }
 }
 
-template <typename BlendFunction, typename BlitRowFunction>
+template <typename BlitRowFunction>
 void SSCanvas::blitConvexPolyCommon(
     const GPoint points[],
     int count,
-    BlendFunction blend,
     BlitRowFunction blitRow
 ) {
     // Run points through ctm
-    GPoint mappedPoints[count];
+    GPoint* mappedPoints = arena.allocate<GPoint>(count);
     GMatrix ctm = getCTM();
     ctm.mapPoints(mappedPoints, points, count);
 
     // Get edge list from points
     GRect bitmap_bounds = GRect::LTRB(0, 0, bitmap.width() - 1, bitmap.height() - 1);
-    std::vector<SSEdge> edges = makeEdges(mappedPoints, count, bitmap_bounds);
+    SSArenaArray<SSEdge> edges(arena, count * 3);
+    makeEdges(mappedPoints, count, bitmap_bounds, edges);
 
     // Find overall top and bottom y
     int min_y = INT32_MAX;
@@ -57,11 +58,12 @@ void SSCanvas::blitConvexPolyCommon(
     SSEdge edge1 = edges[1];
     int nextEdgeIndex = 2;
 
+    SS_STAT_ADD(scanlines, std::max(0, max_y - min_y));
     for (int y = min_y; y < max_y; y++) {
         int left, right;
         findIntersections(left, right, y, edge0, edge1);
 
-        blitRow(left, right, y, blend);
+        blitRow(left, right, y);
         
         advanceEdgeIfExpiring(edge0, nextEdgeIndex, y, edges);
         advanceEdgeIfExpiring(edge1, nextEdgeIndex, y, edges);
@@ -71,149 +73,32 @@ void SSCanvas::blitConvexPolyCommon(
 /// Fill the convex polygon with the color and blendmode,
 /// following the same "containment" rule as rectangles.
 void SSCanvas::drawConvexPolygon(const GPoint points[], int count, const GPaint& paint) {
+    SS_STATS_DRAW(stats, SSDrawType::kConvexPolygon);
+
     const GColor color = paint.getColor();
     GShader *shader = paint.peekShader();
 
     GBlendMode simplifiedBlendMode;
 
     if (shader) {
-        simplifiedBlendMode = simplifyBlendMode(paint.getBlendMode(), shader->isOpaque(), false);
+        simplifiedBlendMode = simplifyBlendModeForDraw(paint.getBlendMode(), shader->isOpaque(), false);
     } else {
-        simplifiedBlendMode = simplifyBlendMode(paint.getBlendMode(), color.a == 1, color.a == 0);
+        simplifiedBlendMode = simplifyBlendModeForDraw(paint.getBlendMode(), color.a == 1, color.a == 0);
     }
 
     // If blend mode is dest, no work to be done
     if (simplifiedBlendMode == GBlendMode::kDst) return;
 
-    if (shader) {
-        // Set CTM as context for shader. Return early if it failed
-        bool setContextWasSuccessful = shader->setContext(getCTM());
-        if (!setContextWasSuccessful) return;
-
-        // Allocate space on stack to store shader results
-        GPixel src[bitmap.width()];
-
-        auto blitRowWithShader = [&src, this, &shader](int left, int right, int y, auto blend) {
-            shader->shadeRow(left, y, right - left, src);
-            GPixel *row = bitmap.getAddr(left, y);
-
-            for (int i = 0; i < right - left; i++) {
-                row[i] = blend(src[i], &row[i]);
-            }
-        };
-
-        switch (simplifiedBlendMode) {
-        case GBlendMode::kClear: {
-            blitConvexPolyCommon(points, count, blendClear, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrc: {
-            blitConvexPolyCommon(points, count, blendSrc, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDst: {
-            // No work to do, can return early
-            return;
-        }
-        case GBlendMode::kSrcOver: {
-            blitConvexPolyCommon(points, count, blendSrcOver, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstOver: {
-            blitConvexPolyCommon(points, count, blendDstOver, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrcIn: {
-            blitConvexPolyCommon(points, count, blendSrcIn, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstIn: {
-            blitConvexPolyCommon(points, count, blendDstIn, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrcOut: {
-            blitConvexPolyCommon(points, count, blendSrcOut, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstOut: {
-            blitConvexPolyCommon(points, count, blendDstOut, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrcATop: {
-            blitConvexPolyCommon(points, count, blendSrcATop, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstATop: {
-            blitConvexPolyCommon(points, count, blendDstATop, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kXor: {
-            blitConvexPolyCommon(points, count, blendXor, blitRowWithShader);
-            break;
-        }
-        }
-    } else {
-        // Premultiply paint color
-        const GPixel src = colorToPixel(paint.getColor());
-
-        auto blitRowWithPixel = [&](int left, int right, int y, auto blend) {
-            GPixel *row = bitmap.getAddr(left, y);
-
-            for (int x = 0; x < right - left; x++) {
-                row[x] = blend(src, &row[x]);
-            }
-        };
-
-        switch (simplifiedBlendMode) {
-        case GBlendMode::kClear: {
-            blitConvexPolyCommon(points, count, blendClear, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrc: {
-            blitConvexPolyCommon(points, count, blendSrc, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDst: {
-            // No work to do, can return early
-            return;
-        }
-        case GBlendMode::kSrcOver: {
-            blitConvexPolyCommon(points, count, blendSrcOver, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDstOver: {
-            blitConvexPolyCommon(points, count, blendDstOver, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrcIn: {
-            blitConvexPolyCommon(points, count, blendSrcIn, blitRowWithPixel);
-            break;
-
-        }
-        case GBlendMode::kDstIn: {
-            blitConvexPolyCommon(points, count, blendDstIn, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrcOut: {
-            blitConvexPolyCommon(points, count, blendSrcOut, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDstOut: {
-            blitConvexPolyCommon(points, count, blendDstOut, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrcATop: {
-            blitConvexPolyCommon(points, count, blendSrcATop, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDstATop: {
-            blitConvexPolyCommon(points, count, blendDstATop, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kXor: {
-            blitConvexPolyCommon(points, count, blendXor, blitRowWithPixel);
-            break;
-        }
-        }
-    }
-}
\ No newline at end of file
+    // Set CTM as context for shader. Return early if it failed
+    SS_STAT_ADD(setContextCalls, shader ? 1 : 0);
+    if (shader && !shader->setContext(getCTM())) return;
+
+    SSArenaScope scratch(arena);
+    SSSpanBlitter blitter(bitmap, arena, simplifiedBlendMode, shader, color, f32Destination());
+
+    blitConvexPolyCommon(points, count, [&blitter](int left, int right, int y) {
+        blitter.addSpan(left, right, y);
+    });
+
+    blitter.flush();
+}
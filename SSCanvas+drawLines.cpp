@@ -0,0 +1,270 @@
+#include "SSCanvas.h"
+#include "SSBlendModeHelpers.h"
+
+/// Step along the hairline p0 -> p1 one pixel at a time along its major axis, calling
+/// plot(x, y, coverage) for each pixel it lights inside [0, width) x [0, height). Coordinates
+/// are relative to pixel centers: pixel (x, y) is centered on (x, y).
+///
+/// The minor coordinate is stepped in 16.16 fixed point. Without AntiAlias it is rounded to one
+/// pixel at full coverage; with it, the pixels on either side split the coverage by distance.
+///
+/// Each pixel is plotted once, and the pixels of a row come together and left to right, so the
+/// caller can batch them into horizontal runs.
+template <bool AntiAlias, typename PlotFunction>
+static void hairline(GPoint p0, GPoint p1, bool includeEnd, int width, int height, PlotFunction plot) {
+    // A non-finite end point leaves no line to step along
+    if (!std::isfinite(p0.x) || !std::isfinite(p0.y) || !std::isfinite(p1.x) || !std::isfinite(p1.y)) return;
+
+    // Work along x, transposing steep lines
+    const bool isSteep = fabsf(p1.y - p0.y) > fabsf(p1.x - p0.x);
+
+    if (isSteep) {
+        std::swap(p0.x, p0.y);
+        std::swap(p1.x, p1.y);
+        std::swap(width, height);
+    }
+
+    auto plotPixel = [&](int major, int minor, unsigned coverage) {
+        if (minor < 0 || minor >= height) return;
+
+        if (isSteep) {
+            plot(minor, major, coverage);
+        } else {
+            plot(major, minor, coverage);
+        }
+    };
+
+    // Clamp the ends to just outside the bitmap before rounding, so far-off points can't overflow
+    // the int. The major axis is clipped to [0, width) below, so this draws the same pixels.
+    int start = GRoundToInt(std::max(-1.0f, std::min(p0.x, static_cast<float>(width))));
+    int end = GRoundToInt(std::max(-1.0f, std::min(p1.x, static_cast<float>(width))));
+
+    if (!includeEnd) {
+        if (start == end) return;
+        end += start < end ? -1 : 1;
+    }
+
+    // Clip the major axis to the bitmap; the minor axis is clipped per pixel
+    const int first = std::max(0, std::min(start, end));
+    const int last = std::min(width - 1, std::max(start, end));
+    if (first > last) return;
+
+    // In double, so the differences of huge (but finite) points can't overflow. Not steep means
+    // |slope| <= 1, so the minor coordinate moves less than width across the clipped span.
+    const double slope = p1.x == p0.x ? 0 : (double(p1.y) - p0.y) / (double(p1.x) - p0.x);
+    const double firstMinor = p0.y + (first - double(p0.x)) * slope;
+    const double lastMinor = firstMinor + (last - first) * slope;
+
+    // Skip lines that pass wholly above or below the bitmap, which also keeps the 16.16 in range
+    if (std::max(firstMinor, lastMinor) < -1 || std::min(firstMinor, lastMinor) > height) return;
+
+    const int64_t firstMinorFixed = llround(firstMinor * 65536);
+    const int64_t minorStep = llround(slope * 65536);
+
+    // A steep line's two anti-aliased pixels share a row. A shallow line's are in different
+    // rows, so it takes one pass for the pixels below the line and another for those above.
+    const int passes = AntiAlias && !isSteep ? 2 : 1;
+
+    for (int pass = 0; pass < passes; pass++) {
+        int64_t minor = firstMinorFixed;
+
+        for (int major = first; major <= last; major++) {
+            if (AntiAlias) {
+                int below = static_cast<int>(minor >> 16);
+                unsigned fraction = (minor >> 8) & 0xFF;
+
+                if (isSteep || pass == 0) plotPixel(major, below, 255 - fraction);
+                if ((isSteep || pass == 1) && fraction != 0) plotPixel(major, below + 1, fraction);
+            } else {
+                plotPixel(major, static_cast<int>((minor + (1 << 15)) >> 16), 255);
+            }
+
+            minor += minorStep;
+        }
+    }
+}
+
+/// Draw each hairline deviceVerts[i * stride] -> deviceVerts[i * stride + 1]. With a stride of
+/// 1 (a polyline) every line but the last leaves out its end point, which starts the next one.
+/// Hairlines blend in 8 bits; with f32Pixels, each pixel they touch is copied back into it.
+///
+/// Plotted pixels are gathered into horizontal runs, and source(x, y, count, row) is asked for
+/// a whole run at once, so a shader costs one shadeRow per run rather than one per pixel.
+template <bool AntiAlias, typename BlendFunction, typename SourceFunction>
+static void drawHairlinesCommon(
+    const GBitmap& bitmap,
+    SSPixelF32* f32Pixels,
+    GBlendMode blendMode,
+    const GPoint deviceVerts[],
+    int count,
+    int stride,
+    SSArena& arena,
+    BlendFunction blend,
+    SourceFunction source
+) {
+    // A run is at most a row long
+    GPixel* src = arena.allocate<GPixel>(bitmap.width());
+    unsigned* coverages = arena.allocate<unsigned>(bitmap.width());
+    int runX = 0;
+    int runY = 0;
+    int runCount = 0;
+
+    auto flush = [&]() {
+        if (runCount == 0) return;
+        SS_STAT_ADD(pixelsBlended[static_cast<int>(blendMode)], runCount);
+
+        source(runX, runY, runCount, src);
+        GPixel* dst = bitmap.getAddr(runX, runY);
+
+        for (int i = 0; i < runCount; i++) {
+            GPixel blended = blend(src[i], &dst[i]);
+            dst[i] = AntiAlias ? lerpPixel(dst[i], blended, coverages[i]) : blended;
+
+            if (f32Pixels) f32Pixels[runY * bitmap.width() + runX + i] = SSPixelF32_fromPixel(dst[i]);
+        }
+
+        runCount = 0;
+    };
+
+    // Only the pixel just right of the run extends it, so a pixel plotted again (where lines
+    // cross) flushes the run first and is blended in order
+    auto plot = [&](int x, int y, unsigned coverage) {
+        if (runCount > 0 && (y != runY || x != runX + runCount)) flush();
+
+        if (runCount == 0) {
+            runX = x;
+            runY = y;
+        }
+
+        coverages[runCount] = coverage;
+        runCount += 1;
+    };
+
+    for (int i = 0; i + 1 < count; i += stride) {
+        bool includeEnd = stride != 1 || i + 2 == count;
+        hairline<AntiAlias>(deviceVerts[i], deviceVerts[i + 1], includeEnd, bitmap.width(), bitmap.height(), plot);
+    }
+
+    flush();
+}
+
+/// Draw count / 2 independent hairlines, pts[0] -> pts[1], pts[2] -> pts[3], ...
+void SSCanvas::drawLines(const GPoint pts[], int count, const GPaint& paint, bool antiAlias) {
+    drawHairlines(pts, count, 2, paint, antiAlias);
+}
+
+/// Draw the connected hairlines pts[0] -> pts[1] -> ... -> pts[count - 1], like drawLines.
+void SSCanvas::drawPolyline(const GPoint pts[], int count, const GPaint& paint, bool antiAlias) {
+    drawHairlines(pts, count, 1, paint, antiAlias);
+}
+
+void SSCanvas::drawHairlines(const GPoint pts[], int count, int stride, const GPaint& paint, bool antiAlias) {
+    SS_STATS_DRAW(stats, SSDrawType::kLines);
+    if (count < 2) return;
+
+    const GColor color = paint.getColor();
+    GShader *shader = paint.peekShader();
+
+    GBlendMode simplifiedBlendMode;
+
+    if (shader) {
+        simplifiedBlendMode = simplifyBlendModeForDraw(paint.getBlendMode(), shader->isOpaque(), false);
+    } else {
+        simplifiedBlendMode = simplifyBlendModeForDraw(paint.getBlendMode(), color.a == 1, color.a == 0);
+    }
+
+    // If blend mode is dest, no work to be done
+    if (simplifiedBlendMode == GBlendMode::kDst) return;
+
+    // Set CTM as context for shader. Return early if it failed
+    SS_STAT_ADD(setContextCalls, shader ? 1 : 0);
+    if (shader && !shader->setContext(getCTM())) return;
+
+    SSArenaScope scratch(arena);
+
+    // Map every point once, shifted so that pixel centers land on whole numbers
+    GPoint* deviceVerts = arena.allocate<GPoint>(count);
+
+    (GMatrix::Translate(-0.5f, -0.5f) * getCTM()).mapPoints(deviceVerts, pts, count);
+
+    // Premultiply paint color
+    const GPixel pixel = colorToPixel(color);
+
+    auto pixelSource = [pixel](int x, int y, int count, GPixel row[]) {
+        std::fill(row, row + count, pixel);
+    };
+
+    auto shaderSource = [shader](int x, int y, int count, GPixel row[]) {
+        SS_STAT_ADD(pixelsShaded, count);
+        shader->shadeRow(x, y, count, row);
+    };
+
+    SSPixelF32* f32Pixels = f32Destination();
+
+    auto drawWithBlend = [&](auto blend) {
+        if (antiAlias) {
+            if (shader) {
+                drawHairlinesCommon<true>(bitmap, f32Pixels, simplifiedBlendMode, deviceVerts, count, stride, arena, blend, shaderSource);
+            } else {
+                drawHairlinesCommon<true>(bitmap, f32Pixels, simplifiedBlendMode, deviceVerts, count, stride, arena, blend, pixelSource);
+            }
+        } else {
+            if (shader) {
+                drawHairlinesCommon<false>(bitmap, f32Pixels, simplifiedBlendMode, deviceVerts, count, stride, arena, blend, shaderSource);
+            } else {
+                drawHairlinesCommon<false>(bitmap, f32Pixels, simplifiedBlendMode, deviceVerts, count, stride, arena, blend, pixelSource);
+            }
+        }
+    };
+
+    switch (simplifiedBlendMode) {
+    case GBlendMode::kClear: {
+        drawWithBlend(blendClear);
+        break;
+    }
+    case GBlendMode::kSrc: {
+        drawWithBlend(blendSrc);
+        break;
+    }
+    case GBlendMode::kDst: {
+        // No work to do, can return early
+        return;
+    }
+    case GBlendMode::kSrcOver: {
+        drawWithBlend(blendSrcOver);
+        break;
+    }
+    case GBlendMode::kDstOver: {
+        drawWithBlend(blendDstOver);
+        break;
+    }
+    case GBlendMode::kSrcIn: {
+        drawWithBlend(blendSrcIn);
+        break;
+    }
+    case GBlendMode::kDstIn: {
+        drawWithBlend(blendDstIn);
+        break;
+    }
+    case GBlendMode::kSrcOut: {
+        drawWithBlend(blendSrcOut);
+        break;
+    }
+    case GBlendMode::kDstOut: {
+        drawWithBlend(blendDstOut);
+        break;
+    }
+    case GBlendMode::kSrcATop: {
+        drawWithBlend(blendSrcATop);
+        break;
+    }
+    case GBlendMode::kDstATop: {
+        drawWithBlend(blendDstATop);
+        break;
+    }
+    case GBlendMode::kXor: {
+        drawWithBlend(blendXor);
+        break;
+    }
+    }
+}
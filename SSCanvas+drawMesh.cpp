@@ -1,36 +1,142 @@
 #include "SSCanvas.h"
+#include "SSBlendModeHelpers.h"
+#include "SSTriangle.h"
+#include "SSSpanBlitter.h"
 #include "SSTriangleColorShader.h"
 #include "SSTriangleTextureShader.h"
 #include "SSTriangleModulatingShader.h"
 
-template <typename MakeShaderFunction, typename UpdateShaderFunction>
-void SSCanvas::drawMeshCommon(
-    const GPoint verts[], 
+/// Spread the 32 bits of value out to the even bits
+static inline uint64_t spreadBits(uint32_t value) {
+    uint64_t spread = value;
+    spread = (spread | (spread << 16)) & 0x0000FFFF0000FFFF;
+    spread = (spread | (spread << 8)) & 0x00FF00FF00FF00FF;
+    spread = (spread | (spread << 4)) & 0x0F0F0F0F0F0F0F0F;
+    spread = (spread | (spread << 2)) & 0x3333333333333333;
+    spread = (spread | (spread << 1)) & 0x5555555555555555;
+    return spread;
+}
+
+/// Position of the pixel (x, y) along a Morton (Z-order) curve. 64 bits, so the order doesn't
+/// wrap around on bitmaps more than 65535 pixels across.
+static inline uint64_t mortonCode(uint32_t x, uint32_t y) {
+    return spreadBits(x) | (spreadBits(y) << 1);
+}
+
+/// Fill visibleIndices (room for triangleCount triples) with the index triples of the triangles
+/// that could draw something: ones without repeated indices, with nonzero area, overlapping
+/// bounds, spanning at least one pixel center in each direction and (if cullBackFaces) clockwise
+/// on screen. Runs before any shader work is done for a triangle. Returns how many indices it wrote.
+static int cullTriangles(
+    const GPoint deviceVerts[],
     int triangleCount,
     const int indices[],
-    const GPaint& paint,
-    MakeShaderFunction makeShader,
-    UpdateShaderFunction updateShader
+    const GRect& bounds,
+    bool cullBackFaces,
+    int visibleIndices[]
+) {
+    int visibleCount = 0;
+
+    for (int i = 0; i < triangleCount * 3; i += 3) {
+        int index0 = indices[i + 0];
+        int index1 = indices[i + 1];
+        int index2 = indices[i + 2];
+
+        if (index0 == index1 || index1 == index2 || index2 == index0) continue;
+
+        const GPoint& p0 = deviceVerts[index0];
+        const GPoint& p1 = deviceVerts[index1];
+        const GPoint& p2 = deviceVerts[index2];
+
+        float cross = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+        if (cross == 0 || (cullBackFaces && cross < 0)) continue;
+
+        float minX = std::min(p0.x, std::min(p1.x, p2.x));
+        float maxX = std::max(p0.x, std::max(p1.x, p2.x));
+        float minY = std::min(p0.y, std::min(p1.y, p2.y));
+        float maxY = std::max(p0.y, std::max(p1.y, p2.y));
+
+        if (maxX < bounds.left || minX > bounds.right || maxY < bounds.top || minY > bounds.bottom) continue;
+
+        // Triangles that fall between pixel centers (x + 0.5, y + 0.5) can't draw anything, which
+        // collapses most of a mesh that is tessellated finer than the pixel grid
+        if (floorf(maxX - 0.5f) < ceilf(minX - 0.5f) || floorf(maxY - 0.5f) < ceilf(minY - 0.5f)) continue;
+
+        visibleIndices[visibleCount++] = index0;
+        visibleIndices[visibleCount++] = index1;
+        visibleIndices[visibleCount++] = index2;
+    }
+
+    return visibleCount;
+}
+
+/// Reorder the triangleCount index triples in triangleIndices along a Morton curve of their
+/// centroids, using scratch space from arena.
+static void sortTrianglesSpatially(
+    const GPoint deviceVerts[],
+    const GRect& bounds,
+    int triangleIndices[],
+    int triangleCount,
+    SSArena& arena
 ) {
-    GPaint newPaint = paint;
+    // (code, first index) pairs, so equal codes keep their original order
+    std::pair<uint64_t, int>* codes = arena.allocate<std::pair<uint64_t, int>>(triangleCount);
+
+    for (int i = 0; i < triangleCount; i++) {
+        const GPoint& p0 = deviceVerts[triangleIndices[i * 3 + 0]];
+        const GPoint& p1 = deviceVerts[triangleIndices[i * 3 + 1]];
+        const GPoint& p2 = deviceVerts[triangleIndices[i * 3 + 2]];
 
-    auto newShader = makeShader(0, 1, 2);
-    newPaint.setShader(newShader);
+        float centroidX = SSClamp((p0.x + p1.x + p2.x) / 3, bounds.left, bounds.right);
+        float centroidY = SSClamp((p0.y + p1.y + p2.y) / 3, bounds.top, bounds.bottom);
+
+        codes[i] = { mortonCode(static_cast<uint32_t>(centroidX), static_cast<uint32_t>(centroidY)), i * 3 };
+    }
 
-    GPoint points[3];
+    std::sort(codes, codes + triangleCount);
+
+    int* sortedIndices = arena.allocate<int>(triangleCount * 3);
+
+    for (int i = 0; i < triangleCount; i++) {
+        memcpy(&sortedIndices[i * 3], &triangleIndices[codes[i].second], 3 * sizeof(int));
+    }
+
+    memcpy(triangleIndices, sortedIndices, triangleCount * 3 * sizeof(int));
+}
+
+template <typename SetTriangleFunction>
+void SSCanvas::drawMeshCommon(
+    const GPoint deviceVerts[],
+    int triangleCount,
+    const int indices[],
+    SetTriangleFunction setTriangle,
+    SSSpanBlitter& blitter
+) {
+    const GIRect clip = GIRect::WH(bitmap.width(), bitmap.height());
+
+    auto blitTriangleRow = [&blitter](int left, int right, int y) {
+        blitter.addSpan(left, right, y);
+    };
 
     int indicesCount = triangleCount * 3;
     for (int i = 0; i < indicesCount; i += 3) {
         int index0 = indices[i + 0];
         int index1 = indices[i + 1];
         int index2 = indices[i + 2];
-        updateShader(newShader, index0, index1, index2);
 
-        points[0] = verts[index0];
-        points[1] = verts[index1];
-        points[2] = verts[index2];
+        const GPoint points[3] = { deviceVerts[index0], deviceVerts[index1], deviceVerts[index2] };
+
+        // The triangle's plane equations: device space -> unit (barycentric) space. Fails for
+        // zero area triangles, which have no pixels to draw anyway.
+        auto deviceToUnit = GMatrix(points[1] - points[0], points[2] - points[0], points[0]).invert();
+        if (!deviceToUnit) continue;
 
-        drawConvexPolygon(points, 3, newPaint);
+        if (!setTriangle(deviceToUnit.value(), index0, index1, index2)) continue;
+        SS_STAT_ADD(trianglesRasterized, 1);
+
+        // The shader is pointed at the next triangle, so this one's spans must be done first
+        SSRasterizeTriangle(points, clip, blitTriangleRow);
+        blitter.flush();
     }
 }
 
@@ -69,51 +175,92 @@ void SSCanvas::drawMesh(
     const int indices[],
     const GPaint& paint
 ) {
-    auto makeColorShader = [&](int index0, int index1, int index2) {
-        return SSCreateTriangleColorShader(
-            verts[index0], verts[index1], verts[index2],
-            colors[index0], colors[index1], colors[index2]
-        );
-    };
+    SS_STATS_DRAW(stats, SSDrawType::kMesh);
 
-    auto updateColorShader = [&](auto colorShader, int index0, int index1, int index2) {
-        colorShader->updateShader(
-            verts[index0], verts[index1], verts[index2],
-            colors[index0], colors[index1], colors[index2]
-        );
-    };
+    // Texture coordinates mean nothing without a shader to look them up in
+    if (paint.peekShader() == nullptr) texs = nullptr;
+    if (colors == nullptr && texs == nullptr) return;
 
-    auto makeTextureShader = [&](int index0, int index1, int index2) {
-        return SSCreateTriangleTextureShader(
-            paint.shareShader(),
-            verts[index0], verts[index1], verts[index2],
-            texs[index0], texs[index1], texs[index2]
-        );
-    };
+    SSArenaScope scratch(arena);
 
-    auto updateTextureShader = [&](auto textureShader, int index0, int index1, int index2) {
-        textureShader->updateShader(
-            verts[index0], verts[index1], verts[index2],
-            texs[index0], texs[index1], texs[index2]
-        );
-    };
+    // Map every vertex by the CTM once, rather than once per triangle that shares it
+    int vertexCount = 0;
+    for (int i = 0; i < triangleCount * 3; i++) {
+        vertexCount = std::max(vertexCount, indices[i] + 1);
+    }
 
-    auto makeModulatingShader = [&](int index0, int index1, int index2) {
-        auto colorShader = makeColorShader(index0, index1, index2);
-        auto textureShader = makeTextureShader(index0, index1, index2);
-        return SSCreateModulatingShader(colorShader, textureShader);
-    };
+    GPoint* deviceVerts = arena.allocate<GPoint>(vertexCount);
+    getCTM().mapPoints(deviceVerts, verts, vertexCount);
+
+    // Drop the triangles that can't draw anything, and optionally put the rest in spatial order
+    const GRect bounds = GRect::WH(bitmap.width(), bitmap.height());
 
-    auto updateModulatingShader = [&](auto modulatingShader, int index0, int index1, int index2) {
-        updateColorShader(modulatingShader->colorShader, index0, index1, index2);
-        updateTextureShader(modulatingShader->textureShader, index0, index1, index2);
+    int* visibleIndices = arena.allocate<int>(triangleCount * 3);
+    triangleCount = cullTriangles(deviceVerts, triangleCount, indices, bounds, meshOptions.cullBackFaces, visibleIndices) / 3;
+
+    if (triangleCount == 0) return;
+    if (meshOptions.spatialOrder) sortTrianglesSpatially(deviceVerts, bounds, visibleIndices, triangleCount, arena);
+
+    indices = visibleIndices;
+
+    // Opacity is decided once for the whole mesh, so the blend mode is only simplified once
+    bool colorsAreOpaque = true;
+    bool colorsAreTransparent = colors != nullptr;
+
+    if (colors != nullptr) {
+        for (int i = 0; i < triangleCount * 3; i++) {
+            float alpha = colors[indices[i]].a;
+            colorsAreOpaque = colorsAreOpaque && alpha == 1;
+            colorsAreTransparent = colorsAreTransparent && alpha == 0;
+        }
+    }
+
+    bool isOpaque = colorsAreOpaque && (texs == nullptr || paint.peekShader()->isOpaque());
+
+    GBlendMode simplifiedBlendMode = simplifyBlendModeForDraw(paint.getBlendMode(), isOpaque, colorsAreTransparent);
+    if (simplifiedBlendMode == GBlendMode::kDst) return;
+
+    auto drawMeshWithShader = [&](GShader* shader, auto setTriangle) {
+        SSSpanBlitter blitter(bitmap, arena, simplifiedBlendMode, shader, GColor(), f32Destination());
+        drawMeshCommon(deviceVerts, triangleCount, indices, setTriangle, blitter);
     };
 
+    // One shader is made per mesh, on the stack, and pointed at each triangle in turn. The
+    // modulating shader borrows the other two through non-owning (aliasing) shared_ptrs, so
+    // nothing is allocated.
     if (colors != nullptr && texs != nullptr) {
-        drawMeshCommon(verts, triangleCount, indices, paint, makeModulatingShader, updateModulatingShader);
+        SSTriangleColorShader colorShader({}, {}, {}, {}, {}, {});
+        SSTriangleTextureShader textureShader(paint.shareShader(), {}, {}, {}, {}, {}, {});
+
+        SSTriangleModulatingShader modulatingShader(
+            std::shared_ptr<SSTriangleColorShader>(std::shared_ptr<void>(), &colorShader),
+            std::shared_ptr<SSTriangleTextureShader>(std::shared_ptr<void>(), &textureShader)
+        );
+
+        drawMeshWithShader(&modulatingShader, [&](const GMatrix& deviceToUnit, int index0, int index1, int index2) {
+            return modulatingShader.setTriangle(
+                deviceToUnit,
+                colors[index0], colors[index1], colors[index2],
+                texs[index0], texs[index1], texs[index2]
+            );
+        });
     } else if (colors != nullptr) {
-        drawMeshCommon(verts, triangleCount, indices, paint, makeColorShader, updateColorShader);
-    } else if (texs != nullptr) {
-        drawMeshCommon(verts, triangleCount, indices, paint, makeTextureShader, updateTextureShader);
+        SSTriangleColorShader colorShader({}, {}, {}, {}, {}, {});
+
+        drawMeshWithShader(&colorShader, [&](const GMatrix& deviceToUnit, int index0, int index1, int index2) {
+            colorShader.setTriangle(deviceToUnit, colors[index0], colors[index1], colors[index2]);
+            return true;
+        });
+    } else {
+        SSTriangleTextureShader textureShader(paint.shareShader(), {}, {}, {}, {}, {}, {});
+
+        drawMeshWithShader(&textureShader, [&](const GMatrix& deviceToUnit, int index0, int index1, int index2) {
+            return textureShader.setTriangle(deviceToUnit, texs[index0], texs[index1], texs[index2]);
+        });
     }
-}
\ No newline at end of file
+}
+
+/// Set the options used by every following drawMesh (and so drawQuad) call.
+void SSCanvas::setMeshOptions(const SSMeshOptions& options) {
+    meshOptions = options;
+}
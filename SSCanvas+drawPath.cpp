@@ -2,9 +2,11 @@
 #include "SSBlendModeHelpers.h"
 #include "SSEdge.h"
 #include "GRect+SSHelpers.h"
+#include "GMatrix+SSHelpers.h"
+#include "SSSpanBlitter.h"
+#include "SSTrace.h"
 
 #include <climits>
-#include <list>
 
 template <typename MakeEdgeFunction>
 void addEdgesFromQuad(
@@ -66,14 +68,32 @@ void addEdgesFromCubic(
     makeEdgeFunction(p0, d);
 }
 
-std::vector<SSEdge> edgesFromPath(const GPath& path, bool pathIsInsideBounds, const GRect& bitmapBounds) {
+/// Number of points Edger returns for each verb
+static int pointsForVerb(GPathVerb verb) {
+    switch (verb) {
+    case GPathVerb::kMove: return 1;
+    case GPathVerb::kLine: return 2;
+    case GPathVerb::kQuad: return 3;
+    case GPathVerb::kCubic: return 4;
+    }
+
+    return 0;
+}
+
+/// Build the edges of the path as mapped by ctm. Each segment's points are mapped as the edger
+/// returns them, so no transformed copy of the path is made.
+void edgesFromPath(
+    const GPath& path,
+    const GMatrix& ctm,
+    bool pathIsInsideBounds,
+    const GRect& bitmapBounds,
+    SSArenaArray<SSEdge>& edges
+) {
     GPath::Edger edger = GPath::Edger(path);
     GPoint points[GPath::kMaxNextPoints];
-    std::vector<SSEdge> edges = std::vector<SSEdge>();
 
     auto makeEdgeNoClip = [&](GPoint p0, GPoint p1) {
-        SSEdge edge = SSEdge::from_points(p0, p1);
-        if (edge.isValid) edges.push_back(edge); 
+        appendEdgeIfValid(SSEdge::from_points(p0, p1), edges);
     };
 
     auto clipAndMakeEdges = [&](GPoint p0, GPoint p1) {
@@ -82,6 +102,8 @@ std::vector<SSEdge> edgesFromPath(const GPath& path, bool pathIsInsideBounds, co
 
     if (pathIsInsideBounds) {
         while (auto verb = edger.next(points)) {
+            ctm.mapPoints(points, pointsForVerb(verb.value()));
+
             switch (verb.value()) {
             case GPathVerb::kMove: {
                 assert(false);
@@ -103,6 +125,8 @@ std::vector<SSEdge> edgesFromPath(const GPath& path, bool pathIsInsideBounds, co
         }
     } else {
         while (auto verb = edger.next(points)) {
+            ctm.mapPoints(points, pointsForVerb(verb.value()));
+
             switch (verb.value()) {
             case GPathVerb::kMove: {
                 assert(false);
@@ -123,12 +147,10 @@ std::vector<SSEdge> edgesFromPath(const GPath& path, bool pathIsInsideBounds, co
             }
         }
     }
-
-    return edges;
 }
 
 /// Sort all edges by y, using initial x as tie breaker
-void sortEdgesByTopThenX(std::vector<SSEdge>& edges) {
+void sortEdgesByTopThenX(SSArenaArray<SSEdge>& edges) {
     std::sort(edges.begin(), edges.end(), [](SSEdge a, SSEdge b) {
         if (a.top != b.top) {
             return a.top < b.top;
@@ -140,61 +162,108 @@ void sortEdgesByTopThenX(std::vector<SSEdge>& edges) {
     });
 }
 
-void sortEdgesInX(std::list<SSEdge>& edges, std::list<SSEdge>::iterator sortEnd, int y) {
-    // Find number of elements to sort
-    const int numToSort = std::distance(edges.begin(), sortEnd);
-
-    // Convert desired portion of list to vector
-    std::vector<SSEdge> edgesToSort(numToSort);
+/// Sort edges by where they cross row y. The order barely changes from one row to the next, so
+/// an insertion sort is close to a single pass.
+void sortEdgesInX(SSEdge edges[], int count, int y) {
+    const float centerY = y + 0.5f;
 
-    int i = 0;
-    for (auto it = edges.begin(); it != sortEnd; it++) {
-        edgesToSort[i] = std::move(*it);
-        i += 1;
-    }
-
-    // Sort edges in vector
-    std::sort(edgesToSort.begin(), edgesToSort.begin() + numToSort, [y](SSEdge a, SSEdge b) {
-        float xA = a.findXforY(y + 0.5f);
-        float xB = b.findXforY(y + 0.5f);
-        return xA < xB;
-    });
+    for (int i = 1; i < count; i++) {
+        SSEdge edge = edges[i];
+        float x = edge.findXforY(centerY);
 
-    // Assign sorted edges back to list
-    int j = 0;
+        int j = i;
+        while (j > 0 && edges[j - 1].findXforY(centerY) > x) {
+            edges[j] = edges[j - 1];
+            j -= 1;
+        }
 
-    for (auto it = edges.begin(); it != sortEnd; it++) {
-        *it = std::move(edgesToSort[j]);
-        j+= 1;
+        edges[j] = edge;
     }
 }
 
-template <typename BlendLambda, typename BlitRowFunction>
-void SSCanvas::drawPathCommon(
-    const GPath& path,
-    const GPaint& paint,
-    BlendLambda blend,
+/// Fill the ellipse inscribed in ovalBounds, as mapped by ctm, one row at a time. Each row's span
+/// is solved for directly from the ellipse's equation, so no edges are built or sorted.
+template <typename BlitRowFunction>
+void blitOvalCommon(
+    const GRect& ovalBounds,
+    const GMatrix& ctm,
+    const GBitmap& bitmap,
     BlitRowFunction blitRowFunction
 ) {
-    // Transform path by CTM
-    auto transformedPath = path.transform(getCTM());
+    // The device ellipse is the unit circle mapped by ovalMatrix
+    const float radiusX = 0.5f * (ovalBounds.right - ovalBounds.left);
+    const float radiusY = 0.5f * (ovalBounds.bottom - ovalBounds.top);
+    const GPoint center = { 0.5f * (ovalBounds.left + ovalBounds.right), 0.5f * (ovalBounds.top + ovalBounds.bottom) };
+
+    const GMatrix ovalMatrix = ctm * GMatrix::Translate(center.x, center.y) * GMatrix::Scale(radiusX, radiusY);
+    const auto inverse = ovalMatrix.invert();
+    if (!inverse) return;
+
+    // A device point (cx + dx, cy + dy) is inside when |inverse * (dx, dy)| <= 1, which along a
+    // row is the quadratic a*dx^2 + 2*b*dx + c <= 0
+    const GMatrix& n = inverse.value();
+    const float a = n[0] * n[0] + n[1] * n[1];
+    const float bPerDy = n[0] * n[2] + n[1] * n[3];
+    const float cPerDy2 = n[2] * n[2] + n[3] * n[3];
+
+    // Rows the ellipse can touch: its half height is the length of ovalMatrix's y row
+    const float centerX = ovalMatrix[4];
+    const float centerY = ovalMatrix[5];
+    const float halfHeight = sqrtf(ovalMatrix[1] * ovalMatrix[1] + ovalMatrix[3] * ovalMatrix[3]);
+
+    const int top = std::max(0, GRoundToInt(centerY - halfHeight));
+    const int bottom = std::min(bitmap.height(), GRoundToInt(centerY + halfHeight));
+    SS_STAT_ADD(scanlines, std::max(0, bottom - top));
+
+    for (int y = top; y < bottom; y++) {
+        const float dy = y + 0.5f - centerY;
+        const float b = bPerDy * dy;
+        const float c = cPerDy2 * dy * dy - 1;
+
+        const float discriminant = b * b - a * c;
+        if (discriminant < 0) continue;
+
+        const float root = sqrtf(discriminant);
+        const int left = std::max(0, GRoundToInt(centerX + (-b - root) / a));
+        const int right = std::min(bitmap.width(), GRoundToInt(centerX + (-b + root) / a));
+
+        if (left < right) blitRowFunction(left, right, y);
+    }
+}
+
+template <typename BlitRowFunction>
+void SSCanvas::drawPathCommon(const GPath& path, BlitRowFunction blitRowFunction) {
+    // Ovals don't need edges at all
+    if (path.shape() == GPathShape::kOval) {
+        SSTraceZone zone("drawPath.scan");
+        blitOvalCommon(path.bounds(), getCTM(), bitmap, blitRowFunction);
+        return;
+    }
+
+    const GMatrix ctm = getCTM();
 
-    // Calculate bitmap and transformed path bounds
+    // Calculate bitmap and transformed path bounds. Mapping the path's cached bounds can only
+    // overestimate, which at worst clips edges that didn't need it.
     const GRect bitmapBounds = GRect::LTRB(0, 0, bitmap.width() - 1, bitmap.height() - 1);
-    const GRect transformedPathBounds = transformedPath->bounds();
+    const GRect transformedPathBounds = GMatrix_mapRect(ctm, path.bounds());
 
     // If entire path is outside bitmap, exit early, no work to do.
     if (GRect_isOutside(transformedPathBounds, bitmapBounds)) return;
 
     // Build edges from path
     bool pathIsInsideBounds = GRect_isInside(transformedPathBounds, bitmapBounds);
-    std::vector<SSEdge> edgesVector = edgesFromPath(*transformedPath, pathIsInsideBounds, bitmapBounds);
+    SSArenaArray<SSEdge> edges(arena);
 
-    // Sort all edges by y, using initial x as tie breaker
-    sortEdgesByTopThenX(edgesVector);
+    {
+        SSTraceZone zone("drawPath.buildEdges");
+        edgesFromPath(path, ctm, pathIsInsideBounds, bitmapBounds, edges);
+    }
 
-    // Convert edges to std::list
-    std::list<SSEdge> edges = std::list<SSEdge>(edgesVector.begin(), edgesVector.end());
+    // Sort all edges by y, using initial x as tie breaker
+    {
+        SSTraceZone zone("drawPath.sortEdges");
+        sortEdgesByTopThenX(edges);
+    }
 
     // Find min and max y values from edges array
     int minY = INT_MAX;
@@ -212,20 +281,32 @@ void SSCanvas::drawPathCommon(
     // Find bounds
     const GIRect bounds = GIRect::LTRB(minX, minY, maxX, maxY);
 
-    // Loop through all y's containing edges
+    // Edges crossing the current row, in x order, and the next edge (by top) to join them
+    SSEdge* activeEdges = arena.allocate<SSEdge>(edges.size());
+    int activeCount = 0;
+    size_t nextEdge = 0;
+
+    // Loop through all y's containing edges. Spans are shaded and blended as they fill batches,
+    // so those zones land inside this one
+    SSTraceZone zone("drawPath.scan");
+    SS_STAT_ADD(scanlines, std::max(0, bounds.bottom - bounds.top));
     for (int y = bounds.top; y < bounds.bottom; y++) {
-        auto edgesIterator = edges.begin();
+        // Activate the edges that start on this row
+        while (nextEdge < edges.size() && edges[nextEdge].top <= y) {
+            if (edges[nextEdge].isValidAtY(y)) activeEdges[activeCount++] = edges[nextEdge];
+            nextEdge += 1;
+        }
+
+        // Sort edges on x intersections of this y
+        sortEdgesInX(activeEdges, activeCount, y);
 
         int w = 0;
         int L;
+        int remaining = 0;
 
         // Loop through all valid edges for this y
-        // while (i < edges.size() && edges[i].isValidAtY(y)) {
-        while (edgesIterator != edges.end()) {
-            const SSEdge currentEdge = *edgesIterator;
-
-            // Stop loop if we've reached an edge that isn't valid for this y
-            if (!currentEdge.isValidAtY(y)) break;
+        for (int i = 0; i < activeCount; i++) {
+            const SSEdge currentEdge = activeEdges[i];
 
             // Find intersection with ray cast
             int x = GRoundToInt(currentEdge.findXforY(y + 0.5f));
@@ -238,30 +319,55 @@ void SSCanvas::drawPathCommon(
 
             // If w now equals zero, fill between this x and L
             if (w == 0) {
-                blitRowFunction(L, x, y, blend);
+                blitRowFunction(L, x, y);
             }
 
-            // Remove the current edge if it won't be hittable for next y
+            // Keep the current edge only if it will be hittable for next y
             if (currentEdge.isValidAtY(y + 1)) {
-                edgesIterator++;
-            } else {
-                edgesIterator = edges.erase(edgesIterator);
+                activeEdges[remaining++] = currentEdge;
             }
         }
 
         assert(w == 0);
+        activeCount = remaining;
+    }
+}
 
-        // Increase iterator until it accounts for all of edges that will be valid for the next y
-        while (edgesIterator != edges.end() && edgesIterator->isValidAtY(y + 1)) {
-            edgesIterator++;
+void SSCanvas::drawPath(const GPath &path, const GPaint &paint) {
+    SS_STATS_DRAW(stats, SSDrawType::kPath);
+    SSTraceZone zone("drawPath");
+
+    SSArenaScope scratch(arena);
+
+    // Hand rects and convex polygons to their own, cheaper, rasterizers
+    switch (path.shape()) {
+    case GPathShape::kRect: {
+        drawRect(path.bounds(), paint);
+        return;
+    }
+    case GPathShape::kConvex: {
+        // Collect the contour's points, leaving out a closing point that repeats the first
+        GPoint* points = arena.allocate<GPoint>(path.countPoints());
+        GPoint next[GPath::kMaxNextPoints];
+        int count = 0;
+
+        GPath::Iter iterator(path);
+
+        while (auto verb = iterator.next(next)) {
+            points[count++] = verb.value() == GPathVerb::kMove ? next[0] : next[1];
         }
 
-        // Sort edges on x intersections of next y
-        sortEdgesInX(edges, edgesIterator, y + 1);
+        if (count > 1 && points[count - 1] == points[0]) count -= 1;
+
+        drawConvexPolygon(points, count, paint);
+        return;
+    }
+    case GPathShape::kOval:
+    case GPathShape::kGeneral: {
+        break;
+    }
     }
-}
 
-void SSCanvas::drawPath(const GPath &path, const GPaint &paint) {
     // Read color and shader from paint
     const GColor color = paint.getColor();
     GShader *shader = paint.peekShader();
@@ -270,141 +376,23 @@ void SSCanvas::drawPath(const GPath &path, const GPaint &paint) {
     GBlendMode simplifiedBlendMode;
 
     if (shader) {
-        simplifiedBlendMode = simplifyBlendMode(paint.getBlendMode(), shader->isOpaque(), false);
+        simplifiedBlendMode = simplifyBlendModeForDraw(paint.getBlendMode(), shader->isOpaque(), false);
     } else {
-        simplifiedBlendMode = simplifyBlendMode(paint.getBlendMode(), color.a == 1, color.a == 0);
+        simplifiedBlendMode = simplifyBlendModeForDraw(paint.getBlendMode(), color.a == 1, color.a == 0);
     }
 
     // If blend mode is dst, no work to be done
     if (simplifiedBlendMode == GBlendMode::kDst) return;
 
-    if (shader) {
-        // Set CTM as context for shader. Return early if it failed
-        bool setContextWasSuccessful = shader->setContext(getCTM());
-        if (!setContextWasSuccessful) return;
-
-        GPixel src[bitmap.width()];
-
-        auto blitRowWithShader = [&src, this, &shader](int left, int right, int y, auto blend) {
-            GPixel *row = this->bitmap.getAddr(left, y);
-            shader->shadeRow(left, y, right - left, src);
+    // Set CTM as context for shader. Return early if it failed
+    SS_STAT_ADD(setContextCalls, shader ? 1 : 0);
+    if (shader && !shader->setContext(getCTM())) return;
 
-            for (int j = 0; j < right - left; j++) {
-                row[j] = blend(src[j], &row[j]);
-            }
-        };
+    SSSpanBlitter blitter(bitmap, arena, simplifiedBlendMode, shader, color, f32Destination());
 
-        switch (simplifiedBlendMode) {
-        case GBlendMode::kClear: {
-            drawPathCommon(path, paint, blendClear, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrc: {
-            drawPathCommon(path, paint, blendSrc, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDst: {
-            // No work to do, can return early
-            return;
-        }
-        case GBlendMode::kSrcOver: {
-            drawPathCommon(path, paint, blendSrcOver, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstOver: {
-            drawPathCommon(path, paint, blendDstOver, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrcIn: {
-            drawPathCommon(path, paint, blendSrcIn, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstIn: {
-            drawPathCommon(path, paint, blendDstIn, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrcOut: {
-            drawPathCommon(path, paint, blendSrcOut, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstOut: {
-            drawPathCommon(path, paint, blendDstOut, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrcATop: {
-            drawPathCommon(path, paint, blendSrcATop, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstATop: {
-            drawPathCommon(path, paint, blendDstATop, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kXor: {
-            drawPathCommon(path, paint, blendXor, blitRowWithShader);
-            break;
-        }
-        }
-    } else {
-        // Premultiply source color
-        GPixel src = colorToPixel(color);
-
-        auto blitRowWithPixel = [&](int left, int right, int y, auto blend) {
-            GPixel *row = bitmap.getAddr(left, y);
-
-            for (int j = 0; j < right - left; j++) {
-                row[j] = blend(src, &row[j]);
-            }
-        };
+    drawPathCommon(path, [&blitter](int left, int right, int y) {
+        blitter.addSpan(left, right, y);
+    });
 
-        switch (simplifiedBlendMode) {
-        case GBlendMode::kClear: {
-            drawPathCommon(path, paint, blendClear, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrc: {
-            drawPathCommon(path, paint, blendSrc, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDst: {
-            // No work to do, can return early
-            return;
-        }
-        case GBlendMode::kSrcOver: {
-            drawPathCommon(path, paint, blendSrcOver, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDstOver: {
-            drawPathCommon(path, paint, blendDstOver, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrcIn: {
-            drawPathCommon(path, paint, blendSrcIn, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDstIn: {
-            drawPathCommon(path, paint, blendDstIn, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrcOut: {
-            drawPathCommon(path, paint, blendSrcOut, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDstOut: {
-            drawPathCommon(path, paint, blendDstOut, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrcATop: {
-            drawPathCommon(path, paint, blendSrcATop, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDstATop: {
-            drawPathCommon(path, paint, blendDstATop, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kXor: {
-            drawPathCommon(path, paint, blendXor, blitRowWithPixel);
-            break;
-        }
-        }
-    }
-};
\ No newline at end of file
+    blitter.flush();
+}
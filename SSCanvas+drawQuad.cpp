@@ -1,12 +1,58 @@
 #include "SSCanvas.h"
+#include "GPoint+SSHelpers.h"
+#include "SSQuadTessellation.h"
 
-template<typename T>
-const T* vectorToArray(const std::vector<T>& vec) {
-    if (vec.empty()) {
-        return nullptr;
-    } else {
-        return vec.data();
+/// Tolerances for kAutoLevel at quality 1: device pixels, color steps and texture units
+const float kQuadGeometryTolerance = 0.25f;
+const float kQuadColorTolerance = 1.0f / 255;
+const float kQuadTextureTolerance = 0.5f;
+
+/// Smallest sub-quad side, in device pixels, that kAutoLevel will tessellate down to
+const float kQuadMinimumSubQuadSize = 4;
+
+/// Most pieces per side kAutoLevel will pick, however large the quad is on screen
+const float kQuadMaximumSegments = 4096;
+
+/// Number of pieces per side a bilinear quad with corners a, b, c, d needs so that drawing each
+/// piece with flat triangles stays within tolerance: its twist |a - b + c - d| / 4 is the most
+/// it strays from flat, and split into n pieces per side each strays 1/n^2 as far.
+static float segmentsForTwist(float twist, float tolerance) {
+    return sqrtf(0.25f * twist / tolerance);
+}
+
+static float pointTwist(const GPoint corners[4]) {
+    GPoint twist = corners[0] - corners[1] + corners[2] - corners[3];
+    return sqrtf(twist.x * twist.x + twist.y * twist.y);
+}
+
+static float colorTwist(const GColor corners[4]) {
+    GColor twist = corners[0] - corners[1] + corners[2] - corners[3];
+    return std::max({ fabsf(twist.r), fabsf(twist.g), fabsf(twist.b), fabsf(twist.a) });
+}
+
+/// The level kAutoLevel resolves to: enough to keep geometry, colors and texture coordinates
+/// within tolerance / quality of the exact bilinear quad, but no sub-quad smaller than
+/// kQuadMinimumSubQuadSize on screen.
+static int autoQuadLevel(
+    const GPoint deviceVerts[4],
+    const GColor colors[4],
+    const GPoint texs[4],
+    float quality
+) {
+    float segments = segmentsForTwist(pointTwist(deviceVerts), kQuadGeometryTolerance / quality);
+    if (colors) segments = std::max(segments, segmentsForTwist(colorTwist(colors), kQuadColorTolerance / quality));
+    if (texs) segments = std::max(segments, segmentsForTwist(pointTwist(texs), kQuadTextureTolerance / quality));
+
+    float longestSide = 0;
+    for (int i = 0; i < 4; i++) {
+        longestSide = std::max(longestSide, GPoint_distance(deviceVerts[i], deviceVerts[(i + 1) % 4]));
     }
+
+    float maxSegments = std::min(kQuadMaximumSegments, std::max(1.0f, longestSide / kQuadMinimumSubQuadSize));
+
+    // Written so that NaN (from non-finite vertices) falls back to the size limit too
+    if (!(segments <= maxSegments)) segments = maxSegments;
+    return static_cast<int>(ceilf(segments)) - 1;
 }
 
 /// Draw the quad, with optional color and/or texture coordinate at each corner. Tesselate
@@ -32,80 +78,47 @@ void SSCanvas::drawQuad(
     int level, 
     const GPaint& paint
 ) {
-    auto quadSample = [](float u, float v, auto a, auto b, auto c, auto d) {
-        return (1-u)*(1-v)*a + (u)*(1-v)*b + (1-u)*(v)*d + (u)*(v)*c;
-    };
-
-    auto sampleFromArray = [quadSample](auto array[4], float u, float v){
-        return quadSample(u, v, array[0], array[1], array[2], array[3]);
-    };
+    SS_STATS_DRAW(stats, SSDrawType::kQuad);
 
-    // Derive number of samples, subquads, and triangles from level
-    const int samplesPerCol = level + 2;
-    const int samplesPerRow = level + 2;
+    SSArenaScope scratch(arena);
 
-    const int subQuadsPerCol = level + 1;
-    const int subQuadsPerRow = level + 1;
-    const int totalSubQuads = subQuadsPerCol * subQuadsPerRow;
-
-    const int totalTriangles = totalSubQuads * 2;
-
-    // Build new vertices, colors, and textures arrays
-    std::vector<GPoint> quadVertices;
-    std::vector<GColor> quadColors;
-    std::vector<GPoint> quadTexturePoints;
+    if (level == kAutoLevel) {
+        GPoint deviceVerts[4];
+        getCTM().mapPoints(deviceVerts, verts, 4);
+        level = std::max(0, autoQuadLevel(deviceVerts, colors, texs, quadQuality));
+    }
 
-    const float fSubQuadsPerCol = subQuadsPerCol;
-    const float fSubQuadsPerRow = subQuadsPerRow;
+    // Any other negative level draws the quad as is
+    level = std::max(0, level);
 
-    for (int col = 0; col < samplesPerCol; col++) {
-        for (int row = 0; row < samplesPerRow; row++) {
-            float u = (float) col / fSubQuadsPerCol;
-            float v = (float) row / fSubQuadsPerRow;
+    const int samplesPerSide = level + 2;
+    const int subQuadsPerSide = level + 1;
+    const int totalSamples = samplesPerSide * samplesPerSide;
+    const int totalTriangles = subQuadsPerSide * subQuadsPerSide * 2;
 
-            quadVertices.push_back(sampleFromArray(verts, u, v));
-            if (colors) quadColors.push_back(sampleFromArray(colors, u, v));
-            if (texs) quadTexturePoints.push_back(sampleFromArray(texs, u, v));
-        }
-    }
+    // Sample the grid into scratch memory, which drawMesh's own scratch stacks on top of
+    GPoint* quadVertices = arena.allocate<GPoint>(totalSamples);
+    GColor* quadColors = colors ? arena.allocate<GColor>(totalSamples) : nullptr;
+    GPoint* quadTexturePoints = texs ? arena.allocate<GPoint>(totalSamples) : nullptr;
 
-    // Build indices array
-    std::vector<int> quadIndices;
-
-    for (int col = 0; col < subQuadsPerCol; col++) {
-        for (int row = 0; row < subQuadsPerRow; row++) {
-            // TL   TR
-            // *-----*
-            // |    /|
-            // |   / |
-            // |  /  |
-            // | /   |
-            // |/    |
-            // *-----*
-            // BL   BR
-            int topLeft     = (row * samplesPerRow) + col;
-            int topRight    = topLeft + 1;
-            int bottomLeft  = topLeft + samplesPerRow;
-            int bottomRight = bottomLeft + 1;
-
-            // Build top left triangle in sub-quad
-            quadIndices.push_back(topLeft);
-            quadIndices.push_back(topRight);
-            quadIndices.push_back(bottomLeft);
-
-            // Build  bottom right triangle in sub-quad
-            quadIndices.push_back(topRight);
-            quadIndices.push_back(bottomRight);
-            quadIndices.push_back(bottomLeft);
-        }
-    }
+    SSFillBilinearGrid(verts, samplesPerSide, quadVertices);
+    if (colors) SSFillBilinearGrid(colors, samplesPerSide, quadColors);
+    if (texs) SSFillBilinearGrid(texs, samplesPerSide, quadTexturePoints);
 
     // Call drawMesh
     this->drawMesh(
-        vectorToArray(quadVertices),
-        vectorToArray(quadColors),
-        vectorToArray(quadTexturePoints),
+        quadVertices,
+        quadColors,
+        quadTexturePoints,
         totalTriangles,
-        vectorToArray(quadIndices),
+        SSQuadIndices(level, arena),
         paint);
-}
\ No newline at end of file
+}
+
+/// Scale the detail drawQuad's kAutoLevel aims for.
+void SSCanvas::setQuadQuality(float quality) {
+    // The tolerances are divided by quality, so only positive, finite values mean anything
+    if (!std::isfinite(quality) || quality <= 0) return;
+
+    quadQuality = quality;
+}
@@ -1,26 +1,18 @@
 #include "SSCanvas.h"
 #include "SSBlendModeHelpers.h"
 #include "GRect+SSHelpers.h"
-
-template <typename BlendFunction, typename BlitRowFunction>
-void blitRectCommon(
-    const GIRect& rect,
-    const GBitmap& bitmap,
-    BlendFunction blend,
-    BlitRowFunction blitRow
-) {
-    for (int y = rect.top; y < rect.bottom; y++) {
-        blitRow(rect.left, rect.right, y, blend);
-    }
-}
+#include "GMatrix+SSHelpers.h"
+#include "SSSpanBlitter.h"
 
 /// Fill the rectangle with the color, using the specified blendmode.
 ///
 /// The affected pixels are those whose centers are "contained" inside the rectangle:
 /// e.g. contained == center > min_edge && center <= max_edge
 void SSCanvas::drawRect(const GRect& rect, const GPaint& paint) {
-    // Call through to drawConvexPoly if rect needs to be transformed
-    if (getCTM() != GMatrix()) {
+    SS_STATS_DRAW(stats, SSDrawType::kRect);
+
+    // Call through to drawConvexPoly if the CTM could turn the rect off its axes
+    if (!GMatrix_isScaleTranslate(getCTM())) {
         GPoint points[4] = {
             { rect.left, rect.top }, { rect.right, rect.top },
             { rect.right, rect.bottom }, { rect.left, rect.bottom }
@@ -31,7 +23,7 @@ void SSCanvas::drawRect(const GRect& rect, const GPaint& paint) {
     }
 
     // Otherwise, draw rectangle normally
-    const GIRect roundedRect = rect.round();
+    const GIRect roundedRect = GMatrix_mapRect(getCTM(), rect).round();
 
     // Exit early if rectangle completely outside bounds
     GIRect bitmapBounds = GIRect::LTRB(0, 0, bitmap.width(), bitmap.height());
@@ -54,143 +46,25 @@ void SSCanvas::drawRect(const GRect& rect, const GPaint& paint) {
     // Simplify blend mode
     GBlendMode simplifiedBlendMode;
     if (shader) {
-        simplifiedBlendMode = simplifyBlendMode(paint.getBlendMode(), shader->isOpaque(), false);
+        simplifiedBlendMode = simplifyBlendModeForDraw(paint.getBlendMode(), shader->isOpaque(), false);
     } else {
-        simplifiedBlendMode = simplifyBlendMode(paint.getBlendMode(), color.a == 1, color.a == 0);
+        simplifiedBlendMode = simplifyBlendModeForDraw(paint.getBlendMode(), color.a == 1, color.a == 0);
     }
 
     // If blend mode is dest, no work to be done
     if (simplifiedBlendMode == GBlendMode::kDst) return;
 
-    if (shader) {
-        // Set CTM as context for shader. Return early if it failed
-        bool setContextWasSuccessful = shader->setContext(getCTM());
-        if (!setContextWasSuccessful) return;
-
-        // Allocate space on stack to store shader results
-        GPixel src[clippedRect.right - clippedRect.left];
-    
-        auto blitRowWithShader = [&src, this, &shader](int left, int right, int y, auto blend) {
-            shader->shadeRow(left, y, right - left, src);
-            GPixel *row = bitmap.getAddr(left, y);
-
-            for (int i = 0; i < right - left; i++) {
-                row[i] = blend(src[i], &row[i]);
-            }
-        };
-
-        switch (simplifiedBlendMode) {
-        case GBlendMode::kClear: {
-            blitRectCommon(clippedRect, bitmap, blendClear, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrc: {
-            blitRectCommon(clippedRect, bitmap, blendSrc, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDst: {
-            // No work to do, can return early
-            return;
-        }
-        case GBlendMode::kSrcOver: {
-            blitRectCommon(clippedRect, bitmap, blendSrcOver, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstOver: {
-            blitRectCommon(clippedRect, bitmap, blendDstOver, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrcIn: {
-            blitRectCommon(clippedRect, bitmap, blendSrcIn, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstIn: {
-            blitRectCommon(clippedRect, bitmap, blendDstIn, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrcOut: {
-            blitRectCommon(clippedRect, bitmap, blendSrcOut, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstOut: {
-            blitRectCommon(clippedRect, bitmap, blendDstOut, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kSrcATop: {
-            blitRectCommon(clippedRect, bitmap, blendSrcATop, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kDstATop: {
-            blitRectCommon(clippedRect, bitmap, blendDstATop, blitRowWithShader);
-            break;
-        }
-        case GBlendMode::kXor: {
-            blitRectCommon(clippedRect, bitmap, blendXor, blitRowWithShader);
-            break;
-        }
-        }
-    } else {
-        // Premultiply source color
-        GPixel src = colorToPixel(color);
-
-        auto blitRowWithPixel = [&](int left, int right, int y, auto blend) {
-            GPixel *row = bitmap.getAddr(left, y);
+    // Set CTM as context for shader. Return early if it failed
+    SS_STAT_ADD(setContextCalls, shader ? 1 : 0);
+    if (shader && !shader->setContext(getCTM())) return;
 
-            for (int x = 0; x < right - left; x++) {
-                row[x] = blend(src, &row[x]);
-            }
-        };
-
-        switch (simplifiedBlendMode) {
-        case GBlendMode::kClear: {
-            blitRectCommon(clippedRect, bitmap, blendClear, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrc: {
-            blitRectCommon(clippedRect, bitmap, blendSrc, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDst: {
-            // No work to do, can return early
-            return;
-        }
-        case GBlendMode::kSrcOver: {
-            blitRectCommon(clippedRect, bitmap, blendSrcOver, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDstOver: {
-            blitRectCommon(clippedRect, bitmap, blendDstOver, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrcIn: {
-            blitRectCommon(clippedRect, bitmap, blendSrcIn, blitRowWithPixel);
-            break;
+    SSArenaScope scratch(arena);
+    SSSpanBlitter blitter(bitmap, arena, simplifiedBlendMode, shader, color, f32Destination());
 
-        }
-        case GBlendMode::kDstIn: {
-            blitRectCommon(clippedRect, bitmap, blendDstIn, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrcOut: {
-            blitRectCommon(clippedRect, bitmap, blendSrcOut, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDstOut: {
-            blitRectCommon(clippedRect, bitmap, blendDstOut, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kSrcATop: {
-            blitRectCommon(clippedRect, bitmap, blendSrcATop, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kDstATop: {
-            blitRectCommon(clippedRect, bitmap, blendDstATop, blitRowWithPixel);
-            break;
-        }
-        case GBlendMode::kXor: {
-            blitRectCommon(clippedRect, bitmap, blendXor, blitRowWithPixel);
-            break;
-        }
-        }
+    SS_STAT_ADD(scanlines, clippedRect.bottom - clippedRect.top);
+    for (int y = clippedRect.top; y < clippedRect.bottom; y++) {
+        blitter.addSpan(clippedRect.left, clippedRect.right, y);
     }
-}
\ No newline at end of file
+
+    blitter.flush();
+}
@@ -26,7 +26,7 @@ std::string GDrawSomething(GCanvas* canvas, GISize dim) {
         verts,
         colors,
         nullptr,
-        12,
+        SSCanvas::kAutoLevel,
         GPaint()
     );
 
@@ -0,0 +1,79 @@
+#include "SSCanvas.h"
+#include "SSBlendModeHelpers.h"
+#include "SSStroker.h"
+#include "SSTriangle.h"
+#include "SSSpanBlitter.h"
+
+/// Stroke the polygon, as if drawing GFinal::strokePolygon's path (round caps and joins),
+/// but straight into the canvas with no intermediate GPath.
+void SSCanvas::strokePolygon(
+    const GPoint pts[],
+    int count,
+    float width,
+    bool isClosed,
+    const GPaint& paint
+) {
+    SS_STATS_DRAW(stats, SSDrawType::kStrokePolygon);
+
+    if (count < 1) return;
+
+    const GColor color = paint.getColor();
+    GShader *shader = paint.peekShader();
+
+    GBlendMode simplifiedBlendMode;
+
+    if (shader) {
+        simplifiedBlendMode = simplifyBlendModeForDraw(paint.getBlendMode(), shader->isOpaque(), false);
+    } else {
+        simplifiedBlendMode = simplifyBlendModeForDraw(paint.getBlendMode(), color.a == 1, color.a == 0);
+    }
+
+    // If blend mode is dest, no work to be done
+    if (simplifiedBlendMode == GBlendMode::kDst) return;
+
+    // Stroke in device space, with the radius scaled by the CTM's average scale
+    GMatrix ctm = getCTM();
+
+    SSArenaScope scratch(arena);
+
+    GPoint* deviceVerts = arena.allocate<GPoint>(count);
+    ctm.mapPoints(deviceVerts, pts, count);
+
+    const float scale = sqrtf(fabsf(ctm[0] * ctm[3] - ctm[1] * ctm[2]));
+    const float radius = scale * width / 2;
+    if (radius <= 0) return;
+
+    // Collect the spans of every piece, then merge them so each pixel is blitted once
+    const GIRect clip = GIRect::WH(bitmap.width(), bitmap.height());
+    SSArenaArray<SSSpan> spans(arena);
+
+    auto addSpan = [&spans](int left, int right, int y) {
+        spans.push_back({ y, left, right });
+    };
+
+    auto addSegment = [&](const GPoint quad[4]) {
+        SSRasterizeConvex<4>(quad, 4, clip, addSpan);
+    };
+
+    // Joins are exact circles here, rather than the polygons a path needs
+    auto addJoin = [&](GPoint center) {
+        SSStrokerRasterizeDisc(center, radius, clip, addSpan);
+    };
+
+    SSStrokerForEachPiece(deviceVerts, count, radius, isClosed, addSegment, addJoin);
+
+    SSSpan_sortAndMerge(spans);
+    if (spans.empty()) return;
+
+    // Set CTM as context for shader. Return early if it failed
+    SS_STAT_ADD(setContextCalls, shader ? 1 : 0);
+    if (shader && !shader->setContext(ctm)) return;
+
+    SSSpanBlitter blitter(bitmap, arena, simplifiedBlendMode, shader, color, f32Destination());
+
+    for (const SSSpan& span : spans) {
+        blitter.addSpan(span.left, span.right, span.y);
+    }
+
+    blitter.flush();
+}
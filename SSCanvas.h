@@ -7,13 +7,44 @@
 #include "include/GBitmap.h"
 #include "include/GShader.h"
 #include "include/GPath.h"
+#include "SSArena.h"
+#include "SSPixelF32.h"
+#include "SSSpan.h"
+#include "SSStats.h"
+
+class SSSpanBlitter;
+
+/// Knobs for how drawMesh walks its triangles. Both default to off, since either can change
+/// what gets drawn: culling drops triangles, and reordering changes how overlapping ones blend.
+struct SSMeshOptions {
+    /// Skip triangles that are counter-clockwise on screen (y pointing down). drawQuad emits its
+    /// triangles clockwise, so they are never culled unless the quad itself is mirrored.
+    bool cullBackFaces = false;
+
+    /// Draw triangles in Morton (Z-curve) order of their centroids rather than index order, so
+    /// consecutive triangles touch nearby destination rows and texture regions.
+    bool spatialOrder = false;
+};
+
+/// What the canvas blends in. k8888 rounds every blend to 8 bits per component, straight into the
+/// bitmap. kF32 keeps a premultiplied float copy of the bitmap and blends fills into that, so
+/// stacked translucent layers don't accumulate rounding error (banding); the bitmap only ever
+/// receives each pixel's latest value, rounded.
+enum class SSPrecision {
+    k8888,
+    kF32,
+};
 
 class SSCanvas : public GCanvas {
 public:
+    /// Level for drawQuad that asks the canvas to choose one
+    static constexpr int kAutoLevel = -1;
+
     /// Instantiate an SSCanvas
     SSCanvas(const GBitmap& bitmap) 
         : matrices({GMatrix()})
         , bitmap(bitmap) 
+        , dstIsOpaque(bitmap.isOpaque())
     {}
 
     /// Save off a copy of the canvas state (CTM), to be later used if the balancing call to
@@ -100,38 +131,137 @@ public:
     ///     3---2
     ///
     /// colors and/or texs can be null. The resulting triangles should be passed to drawMesh(...).
+    ///
+    /// Pass kAutoLevel to have the level picked from the quad's size on screen and how far its
+    /// geometry, colors and texture coordinates are from being linear (see setQuadQuality).
     virtual void drawQuad(
         const GPoint verts[4], const GColor colors[4], 
         const GPoint texs[4], int level, const GPaint&);
 
-private:
-    /// Get the current transformation matrix from the top of the stack.
-    GMatrix getCTM();
+    /// Draw count / 2 independent hairlines, pts[0] -> pts[1], pts[2] -> pts[3], ...
+    ///
+    /// Hairlines are one pixel wide whatever the CTM: only their end points are transformed.
+    /// Without antiAlias each line lights one pixel per step along its major axis; with it, the
+    /// two pixels straddling the line share the coverage (Wu's algorithm).
+    void drawLines(const GPoint pts[], int count, const GPaint&, bool antiAlias = false);
+
+    /// Draw the connected hairlines pts[0] -> pts[1] -> ... -> pts[count - 1], like drawLines.
+    /// Each shared point is only drawn once, so translucent polylines don't darken at corners.
+    void drawPolyline(const GPoint pts[], int count, const GPaint&, bool antiAlias = false);
+
+    /// Stroke the polygon, as if drawing GFinal::strokePolygon's path (round caps and joins),
+    /// but straight into the canvas with no intermediate GPath.
+    ///
+    /// Each segment rectangle and join disc is rasterized in device space, its spans collected,
+    /// then merged per row and blitted once, so translucent paints don't blend twice where the
+    /// pieces overlap. The width is scaled by the CTM's average scale, which is exact for
+    /// rotations, translations and uniform scales.
+    void strokePolygon(const GPoint[], int count, float width, bool isClosed, const GPaint&);
+
+    /// Switch precision modes. Entering kF32 copies the bitmap's pixels into a float buffer, and
+    /// from then on the buffer is the canvas's real destination: pixels changed in the bitmap
+    /// behind the canvas's back are overwritten by the next draw that touches them (call
+    /// setPrecision(kF32) again to pick them up). Leaving kF32 frees the buffer; the bitmap
+    /// already holds every pixel, rounded.
+    ///
+    /// Shaders still produce 8 bit colors, so kF32 removes rounding from blending, not shading.
+    /// Hairlines are drawn in 8 bits either way.
+    ///
+    /// kF32 blends run at roughly 1-2x the time of the same 8 bit blend (make bench, f32_blend_*),
+    /// but constant kClear and kSrc fills are bound by memory bandwidth: they store 20 bytes a
+    /// pixel instead of 4, and take about 8x as long.
+    void setPrecision(SSPrecision);
+
+    /// The float pixels kF32 blends into, row after row with no padding, or null in k8888.
+    const SSPixelF32* peekF32Pixels() const {
+        return f32Pixels.empty() ? nullptr : f32Pixels.data();
+    }
 
+    /// Set the options used by every following drawMesh (and so drawQuad) call.
+    void setMeshOptions(const SSMeshOptions&);
+
+    /// Scale the detail drawQuad's kAutoLevel aims for. 1 (the default) keeps geometry within a
+    /// quarter pixel and colors within one step of exact, 2 halves those tolerances, and so on.
+    /// quality must be positive and finite; anything else is ignored, keeping the current value.
+    void setQuadQuality(float quality);
+
+    /// Get the current transformation matrix from the top of the stack. Public so helpers that
+    /// draw through the canvas (SSFinal's Coons patches) can measure their geometry in device space.
+    GMatrix getCTM() const;
+
+    /// Most scratch memory, in bytes, any draw call on this canvas has needed so far. Scratch
+    /// memory is kept between draws, so once this stops growing drawing doesn't allocate.
+    size_t scratchHighWaterMark() const { return arena.highWaterMark(); }
+
+    /// The scratch arena draw calls use, for helpers outside the canvas that build geometry to
+    /// draw with it. Open an SSArenaScope before allocating from it.
+    SSArena& scratchArena() { return arena; }
+
+    /// What this canvas's draws have done since it was made or resetStats() was last called.
+    /// Always zero unless built with SS_STATS (see SSStats.h).
+    const SSStats& getStats() const { return stats; }
+
+    /// Zero every counter in getStats()
+    void resetStats() { stats = SSStats(); }
+
+private:
     /// Stack of transformation matrices.
     std::vector<GMatrix> matrices;
 
-    /// Shared implementation of drawPath
-    template <typename BlendLambda, typename BlitRowFunction>
-    void drawPathCommon(const GPath&, const GPaint&, BlendLambda, BlitRowFunction);
+    /// Shared implementation of drawPath: calls blitRow(left, right, y) for each span to fill
+    template <typename BlitRowFunction>
+    void drawPathCommon(const GPath&, BlitRowFunction);
+
+    /// Shared implementation of drawConvexPoly: calls blitRow(left, right, y) for each span to fill
+    template <typename BlitRowFunction>
+    void blitConvexPolyCommon(const GPoint[], int count, BlitRowFunction);
 
-    /// Shared implementation of drawConvexPoly
-    template <typename BlendFunction, typename BlitRowFunction>
-    void blitConvexPolyCommon(const GPoint[], int count, BlendFunction, BlitRowFunction);
+    /// Shared implementation of drawLines and drawPolyline
+    void drawHairlines(const GPoint pts[], int count, int stride, const GPaint&, bool antiAlias);
 
-    /// Shared implementation of drawConvexPoly
-    template <typename MakeShaderFunction, typename UpdateShaderFunction>
+    /// Shared implementation of drawMesh: rasterizes each triangle of already mapped vertices
+    template <typename SetTriangleFunction>
     void drawMeshCommon(
-        const GPoint verts[], 
+        const GPoint deviceVerts[],
         int triangleCount,
         const int indices[],
-        const GPaint& paint,
-        MakeShaderFunction makeShader,
-        UpdateShaderFunction updateShader
+        SetTriangleFunction setTriangle,
+        SSSpanBlitter& blitter
     );
 
+    /// Simplify a draw's blend mode for how opaque its source is and whether the destination is
+    /// opaque, and clear dstIsOpaque if the draw might leave it translucent
+    GBlendMode simplifyBlendModeForDraw(GBlendMode, bool srcIsOpaque, bool srcIsTransparent);
+
+    /// Where SSSpanBlitters should blend: the float buffer in kF32, or null for the bitmap
+    SSPixelF32* f32Destination() {
+        return f32Pixels.empty() ? nullptr : f32Pixels.data();
+    }
+
+    /// Options for drawMesh
+    SSMeshOptions meshOptions;
+
+    /// Detail knob for drawQuad's kAutoLevel
+    float quadQuality = 1;
+
+    /// Scratch memory for draw calls: shader rows, edge and span lists, mapped points and
+    /// tessellations. Each draw call opens an SSArenaScope, so it is all released when it returns.
+    SSArena arena;
+
     /// The bitmap that this canvas draws to
     const GBitmap bitmap;
+
+    /// kF32's premultiplied copy of bitmap, one per pixel; empty in k8888
+    std::vector<SSPixelF32> f32Pixels;
+
+    /// Conservatively, whether every pixel is opaque: set by opaque clears (or an opaque
+    /// bitmap) and kept through draws that can't lower alpha, like src-over. Lets
+    /// simplifyBlendModeForDraw drop the destination alpha terms from DstOver, SrcATop, Xor and
+    /// the like. Pixels changed behind the canvas's back must stay opaque.
+    bool dstIsOpaque;
+
+    /// Counters for getStats(), added to while a draw call is running
+    SSStats stats;
 };
 
 #endif
\ No newline at end of file
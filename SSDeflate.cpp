@@ -0,0 +1,805 @@
+#include "SSDeflate.h"
+#include <algorithm>
+#include <cstring>
+
+/// Farthest back a match may reach, and the shortest and longest match
+static constexpr uint32_t kWindowSize = 32768;
+static constexpr uint32_t kMinMatch = 3;
+static constexpr uint32_t kMaxMatch = 258;
+
+/// Window plus room for new input, so the window only slides once per 96K of input
+static constexpr uint32_t kBufferSize = 4 * kWindowSize;
+
+static constexpr int kHashBits = 15;
+
+/// Largest stored block
+static constexpr uint32_t kMaxStoredBlock = 65535;
+
+/// Symbols per Huffman block: enough for the codes to fit the data, few enough to follow it
+static constexpr size_t kBlockSymbols = 16384;
+
+static constexpr int kLiteralCodes = 286;
+static constexpr int kDistanceCodes = 30;
+static constexpr int kCodeLengthCodes = 19;
+static constexpr int kEndOfBlock = 256;
+
+/// A 3 byte match this far back costs more bits than its three literals (zlib's TOO_FAR)
+static constexpr uint32_t kTooFar = 4096;
+
+/// How long a chain each mode searches, when a match is long enough to stop searching, and
+/// the longest match whose every position is still added to the hash chains
+struct SSDeflateSettings {
+    int chainLength;
+    uint32_t niceLength;
+    uint32_t maxInsertLength;
+};
+
+static SSDeflateSettings settingsFor(SSCompression compression) {
+    switch (compression) {
+    case SSCompression::kStore:
+    case SSCompression::kFast:
+        return { 8, 32, 16 };
+    case SSCompression::kBest:
+        return { 4096, kMaxMatch, kMaxMatch };
+    }
+
+    return { 8, 32, 16 };
+}
+
+// MARK: Tables
+
+/// RFC 1951 section 3.2.5: each length and distance code's smallest value and extra bits, and
+/// the length code for every match length. Built at compile time.
+struct SSDeflateTables {
+    uint16_t lengthBase[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    uint8_t lengthExtraBits[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+    uint16_t distanceBase[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+    uint8_t distanceExtraBits[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+    uint8_t lengthCode[kMaxMatch + 1] = {};
+
+    constexpr SSDeflateTables() {
+        for (int code = 0; code < 29; code++) {
+            uint32_t end = std::min<uint32_t>(lengthBase[code] + (1u << lengthExtraBits[code]), kMaxMatch + 1);
+            for (uint32_t length = lengthBase[code]; length < end; length++) {
+                lengthCode[length] = code;
+            }
+        }
+    }
+};
+
+static constexpr SSDeflateTables kTables;
+
+/// Code for a distance in [1, 32768]: two codes per power of two past the first four
+static inline int distanceCode(uint32_t distance) {
+    uint32_t x = distance - 1;
+    if (x < 4) return x;
+
+    int bits = 31 - __builtin_clz(x);
+    return 2 * bits + ((x >> (bits - 1)) & 1);
+}
+
+// MARK: Huffman Codes
+
+/// Lengths of a Huffman code for the given frequencies, none longer than maxLength. Symbols
+/// that never occur get length 0.
+///
+/// The code is built with the two-queue method on symbols sorted by frequency, then any length
+/// over maxLength is cut down to it and codes are lengthened one at a time until the lengths
+/// describe a complete code again (the same repair miniz does).
+static void buildCodeLengths(const uint32_t frequencies[], int count, int maxLength, uint8_t lengths[]) {
+    int symbols[kLiteralCodes];
+    int used = 0;
+
+    for (int symbol = 0; symbol < count; symbol++) {
+        lengths[symbol] = 0;
+        if (frequencies[symbol] > 0) symbols[used++] = symbol;
+    }
+
+    if (used == 0) return;
+    if (used == 1) {
+        lengths[symbols[0]] = 1;
+        return;
+    }
+
+    std::sort(symbols, symbols + used, [&](int lhs, int rhs) {
+        return frequencies[lhs] != frequencies[rhs] ? frequencies[lhs] < frequencies[rhs] : lhs < rhs;
+    });
+
+    // Leaves are nodes [0, used) in frequency order; internal nodes follow, and are created in
+    // order of weight, so the lightest node is always at the front of one of the two queues
+    uint32_t weights[2 * kLiteralCodes];
+    int parents[2 * kLiteralCodes];
+    int depths[2 * kLiteralCodes];
+
+    for (int i = 0; i < used; i++) {
+        weights[i] = frequencies[symbols[i]];
+    }
+
+    int nextLeaf = 0;
+    int nextInternal = used;
+    int nodeCount = used;
+
+    auto popLightest = [&]() {
+        if (nextLeaf < used && (nextInternal == nodeCount || weights[nextLeaf] <= weights[nextInternal])) {
+            return nextLeaf++;
+        }
+        return nextInternal++;
+    };
+
+    for (int i = 0; i < used - 1; i++) {
+        int lhs = popLightest();
+        int rhs = popLightest();
+
+        weights[nodeCount] = weights[lhs] + weights[rhs];
+        parents[lhs] = nodeCount;
+        parents[rhs] = nodeCount;
+        nodeCount++;
+    }
+
+    // Parents always come after their children
+    depths[nodeCount - 1] = 0;
+    for (int node = nodeCount - 2; node >= 0; node--) {
+        depths[node] = depths[parents[node]] + 1;
+    }
+
+    // Count codes per length, cutting the long ones to maxLength
+    int lengthCounts[16] = {};
+    for (int i = 0; i < used; i++) {
+        lengthCounts[std::min(depths[i], maxLength)]++;
+    }
+
+    // The Kraft sum, in units of the shortest code. Each pass of the loop drops one code from
+    // maxLength and splits a shorter one into two one bit longer, lowering the sum by one.
+    uint32_t total = 0;
+    for (int length = 1; length <= maxLength; length++) {
+        total += static_cast<uint32_t>(lengthCounts[length]) << (maxLength - length);
+    }
+
+    while (total != (1u << maxLength)) {
+        lengthCounts[maxLength]--;
+
+        for (int length = maxLength - 1; length > 0; length--) {
+            if (lengthCounts[length] > 0) {
+                lengthCounts[length]--;
+                lengthCounts[length + 1] += 2;
+                break;
+            }
+        }
+
+        total--;
+    }
+
+    // Hand the longest codes to the rarest symbols
+    int next = 0;
+    for (int length = maxLength; length > 0; length--) {
+        for (int i = 0; i < lengthCounts[length]; i++) {
+            lengths[symbols[next++]] = length;
+        }
+    }
+}
+
+/// Canonical codes for the lengths, bit reversed since DEFLATE sends codes most significant
+/// bit first into a least significant bit first stream.
+static void buildCodes(const uint8_t lengths[], int count, uint16_t codes[]) {
+    int lengthCounts[16] = {};
+    for (int symbol = 0; symbol < count; symbol++) {
+        lengthCounts[lengths[symbol]]++;
+    }
+    lengthCounts[0] = 0;
+
+    uint32_t nextCode[16] = {};
+    uint32_t code = 0;
+    for (int length = 1; length < 16; length++) {
+        code = (code + lengthCounts[length - 1]) << 1;
+        nextCode[length] = code;
+    }
+
+    for (int symbol = 0; symbol < count; symbol++) {
+        const int length = lengths[symbol];
+        if (length == 0) continue;
+
+        uint32_t forward = nextCode[length]++;
+        uint32_t reversed = 0;
+        for (int bit = 0; bit < length; bit++) {
+            reversed = (reversed << 1) | ((forward >> bit) & 1);
+        }
+
+        codes[symbol] = static_cast<uint16_t>(reversed);
+    }
+}
+
+/// The fixed codes of RFC 1951 section 3.2.6
+struct SSFixedCodes {
+    uint8_t literalLengths[288];
+    uint16_t literalCodes[288];
+    uint8_t distanceLengths[30];
+    uint16_t distanceCodes[30];
+
+    SSFixedCodes() {
+        for (int symbol = 0; symbol < 288; symbol++) {
+            literalLengths[symbol] = symbol < 144 ? 8 : (symbol < 256 ? 9 : (symbol < 280 ? 7 : 8));
+        }
+        std::fill(distanceLengths, distanceLengths + 30, 5);
+
+        buildCodes(literalLengths, 288, literalCodes);
+        buildCodes(distanceLengths, 30, distanceCodes);
+    }
+};
+
+static const SSFixedCodes& fixedCodes() {
+    static const SSFixedCodes codes;
+    return codes;
+}
+
+// MARK: Deflater
+
+SSDeflater::SSDeflater(SSCompression compression, std::vector<uint8_t>& out)
+    : compression(compression)
+    , out(out)
+    , buffer(kBufferSize)
+{
+    if (compression != SSCompression::kStore) {
+        head.assign(1 << kHashBits, 0);
+        previous.assign(kWindowSize, 0);
+        symbols.reserve(kBlockSymbols);
+    }
+}
+
+/// Compress size more bytes.
+void SSDeflater::write(const uint8_t data[], size_t size) {
+    while (size > 0) {
+        if (bufferEnd == kBufferSize) makeRoom();
+
+        const size_t count = std::min<size_t>(size, kBufferSize - bufferEnd);
+        memcpy(buffer.data() + bufferEnd, data, count);
+        bufferEnd += count;
+        data += count;
+        size -= count;
+
+        // Compress up to where every match can still reach its full length
+        const uint32_t end = bufferEnd;
+
+        if (compression == SSCompression::kStore) {
+            storeBuffered(false);
+        } else if (end >= kMaxMatch && position < end - kMaxMatch) {
+            if (compression == SSCompression::kFast) {
+                compressGreedy(end - kMaxMatch);
+            } else {
+                compressLazy(end - kMaxMatch);
+            }
+        }
+    }
+}
+
+/// Compress whatever is still buffered and end the stream with a final block, or if this isn't
+/// the last part of the stream, a sync flush.
+void SSDeflater::finish(bool isLast) {
+    if (compression == SSCompression::kStore) {
+        // Stored blocks already end on a byte boundary
+        storeBuffered(true, isLast);
+        return;
+    }
+
+    const uint32_t end = bufferEnd;
+
+    if (compression == SSCompression::kFast) {
+        compressGreedy(end);
+    } else {
+        compressLazy(end);
+    }
+
+    if (isLast) {
+        writeBlock(true);
+        alignToByte();
+        return;
+    }
+
+    if (!symbols.empty()) writeBlock(false);
+
+    // An empty stored block: its header, padding to a byte, then LEN 0 and NLEN 0xFFFF
+    putBits(0, 3);
+    alignToByte();
+
+    const uint8_t lengths[4] = { 0x00, 0x00, 0xFF, 0xFF };
+    out.insert(out.end(), lengths, lengths + 4);
+}
+
+/// Drop input that is out of the match window, to make room at the end of the buffer.
+///
+/// Positions count from the start of the buffer, so they are rebased here rather than growing
+/// with the stream (which would wrap a 32 bit position after 4 GiB), as zlib slides its window.
+void SSDeflater::makeRoom() {
+    // Stored blocks need no history; matches need the window, and kBest the byte before
+    // position. The hash chains index previous by position modulo the window, so they can
+    // only be slid by whole windows.
+    uint32_t shift = position;
+    if (compression != SSCompression::kStore) {
+        shift = position > kWindowSize + 1 ? position - kWindowSize - 1 : 0;
+        shift -= shift % kWindowSize;
+    }
+
+    if (shift == 0) return;
+
+    memmove(buffer.data(), buffer.data() + shift, bufferEnd - shift);
+    bufferEnd -= shift;
+    position -= shift;
+
+    // Chain entries are position + 1, or 0 for none; those that slid out of the buffer go
+    auto rebase = [shift](uint32_t& entry) {
+        entry = entry > shift ? entry - shift : 0;
+    };
+
+    std::for_each(head.begin(), head.end(), rebase);
+    std::for_each(previous.begin(), previous.end(), rebase);
+}
+
+/// Emit stored blocks for buffered input, leaving less than a full block unless finishing.
+void SSDeflater::storeBuffered(bool finishing, bool isLast) {
+    const uint32_t end = bufferEnd;
+
+    while (end - position >= kMaxStoredBlock || finishing) {
+        const uint32_t length = std::min(end - position, kMaxStoredBlock);
+        const bool isFinal = finishing && isLast && position + length == end;
+
+        // Header, then LEN and NLEN from the next byte boundary
+        putBits(isFinal ? 1 : 0, 3);
+        alignToByte();
+
+        const uint8_t lengths[4] = {
+            static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8),
+            static_cast<uint8_t>(~length), static_cast<uint8_t>(~length >> 8)
+        };
+        out.insert(out.end(), lengths, lengths + 4);
+
+        const uint8_t* data = buffer.data() + position;
+        out.insert(out.end(), data, data + length);
+        position += length;
+
+        if (finishing && position == end) break;
+    }
+}
+
+static inline uint32_t hash3(const uint8_t* data) {
+    const uint32_t bytes = data[0] | (data[1] << 8) | (data[2] << 16);
+    return (bytes * 2654435761u) >> (32 - kHashBits);
+}
+
+void SSDeflater::insertHash(uint32_t position) {
+    const uint32_t hash = hash3(buffer.data() + position);
+    previous[position & (kWindowSize - 1)] = head[hash];
+    head[hash] = position + 1;
+}
+
+/// Length of the common prefix of lhs and rhs, up to maxLength, eight bytes at a time
+static inline uint32_t matchLength(const uint8_t* lhs, const uint8_t* rhs, uint32_t maxLength) {
+    uint32_t length = 0;
+
+    while (length + 8 <= maxLength) {
+        uint64_t lhsWord, rhsWord;
+        memcpy(&lhsWord, lhs + length, 8);
+        memcpy(&rhsWord, rhs + length, 8);
+
+        const uint64_t difference = lhsWord ^ rhsWord;
+        if (difference != 0) {
+            return length + (__builtin_ctzll(difference) >> 3);
+        }
+
+        length += 8;
+    }
+
+    while (length < maxLength && lhs[length] == rhs[length]) {
+        length++;
+    }
+
+    return length;
+}
+
+/// Longest match for the bytes at position along its hash chain. Needs kMinMatch bytes there.
+SSDeflater::Match SSDeflater::findMatch(uint32_t position) {
+    static_assert(kMinMatch == 3, "findMatch hashes three bytes");
+
+    const SSDeflateSettings settings = settingsFor(compression);
+    const uint8_t* data = buffer.data() + position;
+    const uint32_t maxLength = std::min(kMaxMatch, bufferEnd - position);
+
+    Match best = { 0, 0 };
+    uint32_t candidate = head[hash3(data)];
+
+    for (int chain = settings.chainLength; candidate != 0 && chain > 0; chain--) {
+        const uint32_t start = candidate - 1;
+        if (start >= position || position - start > kWindowSize) break;
+
+        const uint8_t* match = buffer.data() + start;
+
+        // A longer match has to agree at best.length first
+        if (match[best.length] == data[best.length] && match[0] == data[0]) {
+            const uint32_t length = matchLength(match, data, maxLength);
+
+            if (length > best.length) {
+                best = { length, position - start };
+                if (length >= settings.niceLength || length == maxLength) break;
+            }
+        }
+
+        // Chains can point at overwritten entries; those never lead further back
+        const uint32_t next = previous[start & (kWindowSize - 1)];
+        if (next >= candidate) break;
+        candidate = next;
+    }
+
+    if (best.length < kMinMatch || (best.length == kMinMatch && best.distance > kTooFar)) {
+        return { 0, 0 };
+    }
+
+    return best;
+}
+
+/// Turn buffered input before limit into symbols, taking the longest match at each position.
+void SSDeflater::compressGreedy(uint32_t limit) {
+    const SSDeflateSettings settings = settingsFor(compression);
+    const uint32_t end = bufferEnd;
+
+    while (position < limit) {
+        if (end - position < kMinMatch) {
+            emitLiteral(buffer[position]);
+            position++;
+            continue;
+        }
+
+        const Match match = findMatch(position);
+        insertHash(position);
+
+        if (match.length == 0) {
+            emitLiteral(buffer[position]);
+            position++;
+            continue;
+        }
+
+        emitMatch(match);
+
+        if (match.length <= settings.maxInsertLength) {
+            for (uint32_t i = 1; i < match.length && end - (position + i) >= kMinMatch; i++) {
+                insertHash(position + i);
+            }
+        }
+
+        position += match.length;
+    }
+}
+
+/// Turn buffered input before limit into symbols. Each match is held back one position, and
+/// dropped for a literal if the next position has a longer one.
+void SSDeflater::compressLazy(uint32_t limit) {
+    const uint32_t end = bufferEnd;
+
+    while (position < limit) {
+        Match match = { 0, 0 };
+
+        if (end - position >= kMinMatch) {
+            match = findMatch(position);
+            insertHash(position);
+        }
+
+        if (pending.length > 0) {
+            if (match.length > pending.length) {
+                // The pending match loses: its first byte goes out as a literal
+                emitLiteral(buffer[position - 1]);
+                pending = match;
+                position++;
+                continue;
+            }
+
+            // The pending match started at position - 1; hash the rest of it and skip past it
+            const uint32_t matchEnd = position - 1 + pending.length;
+            emitMatch(pending);
+
+            for (uint32_t i = position + 1; i < matchEnd && end - i >= kMinMatch; i++) {
+                insertHash(i);
+            }
+
+            pending = { 0, 0 };
+            position = matchEnd;
+            continue;
+        }
+
+        if (match.length > 0) {
+            pending = match;
+        } else {
+            emitLiteral(buffer[position]);
+        }
+
+        position++;
+    }
+
+    // At the end of the input there's no next position to compare with
+    if (limit == end && pending.length > 0) {
+        emitMatch(pending);
+        position = position - 1 + pending.length;
+        pending = { 0, 0 };
+    }
+}
+
+void SSDeflater::emitLiteral(uint8_t literal) {
+    symbols.push_back({ literal, 0 });
+    literalFrequencies[literal]++;
+
+    if (symbols.size() == kBlockSymbols) writeBlock(false);
+}
+
+void SSDeflater::emitMatch(const Match& match) {
+    symbols.push_back({ static_cast<uint16_t>(match.length), static_cast<uint16_t>(match.distance) });
+    literalFrequencies[257 + kTables.lengthCode[match.length]]++;
+    distanceFrequencies[distanceCode(match.distance)]++;
+
+    if (symbols.size() == kBlockSymbols) writeBlock(false);
+}
+
+/// Code lengths sent ahead of a dynamic block's codes, in this order
+static constexpr uint8_t kCodeLengthOrder[kCodeLengthCodes] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+/// A code length code (0-15 literal lengths, 16-18 repeats) and its extra bits
+struct SSCodeLengthSymbol {
+    uint8_t symbol;
+    uint8_t extra;
+};
+
+/// Run-length code lengths as RFC 1951 section 3.2.7 describes, returning the symbol count
+static int runLengthEncode(const uint8_t lengths[], int count, SSCodeLengthSymbol encoded[]) {
+    int encodedCount = 0;
+
+    for (int i = 0; i < count;) {
+        const uint8_t length = lengths[i];
+        int run = 1;
+        while (i + run < count && lengths[i + run] == length) run++;
+        i += run;
+
+        if (length == 0) {
+            while (run >= 11) {
+                const int repeat = std::min(run, 138);
+                encoded[encodedCount++] = { 18, static_cast<uint8_t>(repeat - 11) };
+                run -= repeat;
+            }
+            if (run >= 3) {
+                encoded[encodedCount++] = { 17, static_cast<uint8_t>(run - 3) };
+                run = 0;
+            }
+        } else {
+            encoded[encodedCount++] = { length, 0 };
+            run--;
+
+            while (run >= 3) {
+                const int repeat = std::min(run, 6);
+                encoded[encodedCount++] = { 16, static_cast<uint8_t>(repeat - 3) };
+                run -= repeat;
+            }
+        }
+
+        while (run-- > 0) {
+            encoded[encodedCount++] = { length, 0 };
+        }
+    }
+
+    return encodedCount;
+}
+
+/// Extra bits after each code length code
+static inline int codeLengthExtraBits(int symbol) {
+    return symbol == 16 ? 2 : (symbol == 17 ? 3 : (symbol == 18 ? 7 : 0));
+}
+
+/// Huffman code the queued symbols as one block, with fixed or dynamic codes, whichever is smaller.
+void SSDeflater::writeBlock(bool isFinal) {
+    literalFrequencies[kEndOfBlock] = 1;
+
+    // Decoders want complete codes, so give each tree at least two symbols
+    if (std::count_if(distanceFrequencies, distanceFrequencies + kDistanceCodes, [](uint32_t f) { return f > 0; }) < 2) {
+        distanceFrequencies[0] = std::max(distanceFrequencies[0], 1u);
+        distanceFrequencies[1] = std::max(distanceFrequencies[1], 1u);
+    }
+    if (std::count_if(literalFrequencies, literalFrequencies + kLiteralCodes, [](uint32_t f) { return f > 0; }) < 2) {
+        literalFrequencies[0] = std::max(literalFrequencies[0], 1u);
+    }
+
+    uint8_t literalLengths[kLiteralCodes];
+    uint8_t distanceLengths[kDistanceCodes];
+    buildCodeLengths(literalFrequencies, kLiteralCodes, 15, literalLengths);
+    buildCodeLengths(distanceFrequencies, kDistanceCodes, 15, distanceLengths);
+
+    int literalCount = kLiteralCodes;
+    while (literalCount > 257 && literalLengths[literalCount - 1] == 0) literalCount--;
+    int distanceCount = kDistanceCodes;
+    while (distanceCount > 1 && distanceLengths[distanceCount - 1] == 0) distanceCount--;
+
+    // Both trees' lengths are run-length coded as one sequence, with a code of their own
+    uint8_t allLengths[kLiteralCodes + kDistanceCodes];
+    std::copy(literalLengths, literalLengths + literalCount, allLengths);
+    std::copy(distanceLengths, distanceLengths + distanceCount, allLengths + literalCount);
+
+    SSCodeLengthSymbol encoded[kLiteralCodes + kDistanceCodes];
+    const int encodedCount = runLengthEncode(allLengths, literalCount + distanceCount, encoded);
+
+    uint32_t codeLengthFrequencies[kCodeLengthCodes] = {};
+    for (int i = 0; i < encodedCount; i++) {
+        codeLengthFrequencies[encoded[i].symbol]++;
+    }
+
+    uint8_t codeLengthLengths[kCodeLengthCodes];
+    buildCodeLengths(codeLengthFrequencies, kCodeLengthCodes, 7, codeLengthLengths);
+
+    int codeLengthCount = kCodeLengthCodes;
+    while (codeLengthCount > 4 && codeLengthLengths[kCodeLengthOrder[codeLengthCount - 1]] == 0) codeLengthCount--;
+
+    // Compare sizes; extra bits cost the same either way
+    const SSFixedCodes& fixed = fixedCodes();
+    uint64_t dynamicBits = 5 + 5 + 4 + 3 * codeLengthCount;
+    uint64_t fixedBits = 0;
+
+    for (int i = 0; i < encodedCount; i++) {
+        dynamicBits += codeLengthLengths[encoded[i].symbol] + codeLengthExtraBits(encoded[i].symbol);
+    }
+    for (int symbol = 0; symbol < kLiteralCodes; symbol++) {
+        dynamicBits += uint64_t(literalFrequencies[symbol]) * literalLengths[symbol];
+        fixedBits += uint64_t(literalFrequencies[symbol]) * fixed.literalLengths[symbol];
+    }
+    for (int symbol = 0; symbol < kDistanceCodes; symbol++) {
+        dynamicBits += uint64_t(distanceFrequencies[symbol]) * distanceLengths[symbol];
+        fixedBits += uint64_t(distanceFrequencies[symbol]) * fixed.distanceLengths[symbol];
+    }
+
+    const bool useFixed = fixedBits <= dynamicBits;
+
+    uint16_t dynamicLiteralCodes[kLiteralCodes];
+    uint16_t dynamicDistanceCodes[kDistanceCodes];
+    const uint8_t* literalLengthTable = fixed.literalLengths;
+    const uint16_t* literalCodeTable = fixed.literalCodes;
+    const uint8_t* distanceLengthTable = fixed.distanceLengths;
+    const uint16_t* distanceCodeTable = fixed.distanceCodes;
+
+    putBits(isFinal ? 1 : 0, 1);
+
+    if (useFixed) {
+        putBits(1, 2);
+    } else {
+        putBits(2, 2);
+        putBits(literalCount - 257, 5);
+        putBits(distanceCount - 1, 5);
+        putBits(codeLengthCount - 4, 4);
+
+        for (int i = 0; i < codeLengthCount; i++) {
+            putBits(codeLengthLengths[kCodeLengthOrder[i]], 3);
+        }
+
+        uint16_t codeLengthCodes[kCodeLengthCodes];
+        buildCodes(codeLengthLengths, kCodeLengthCodes, codeLengthCodes);
+
+        for (int i = 0; i < encodedCount; i++) {
+            const int symbol = encoded[i].symbol;
+            putBits(codeLengthCodes[symbol], codeLengthLengths[symbol]);
+            if (symbol >= 16) putBits(encoded[i].extra, codeLengthExtraBits(symbol));
+        }
+
+        buildCodes(literalLengths, kLiteralCodes, dynamicLiteralCodes);
+        buildCodes(distanceLengths, kDistanceCodes, dynamicDistanceCodes);
+
+        literalLengthTable = literalLengths;
+        literalCodeTable = dynamicLiteralCodes;
+        distanceLengthTable = distanceLengths;
+        distanceCodeTable = dynamicDistanceCodes;
+    }
+
+    for (const Symbol& symbol : symbols) {
+        if (symbol.distance == 0) {
+            putBits(literalCodeTable[symbol.literalOrLength], literalLengthTable[symbol.literalOrLength]);
+            continue;
+        }
+
+        const int lengthCode = kTables.lengthCode[symbol.literalOrLength];
+        putBits(literalCodeTable[257 + lengthCode], literalLengthTable[257 + lengthCode]);
+        putBits(symbol.literalOrLength - kTables.lengthBase[lengthCode], kTables.lengthExtraBits[lengthCode]);
+
+        const int distanceCode = ::distanceCode(symbol.distance);
+        putBits(distanceCodeTable[distanceCode], distanceLengthTable[distanceCode]);
+        putBits(symbol.distance - kTables.distanceBase[distanceCode], kTables.distanceExtraBits[distanceCode]);
+    }
+
+    putBits(literalCodeTable[kEndOfBlock], literalLengthTable[kEndOfBlock]);
+
+    symbols.clear();
+    std::fill(literalFrequencies, literalFrequencies + kLiteralCodes, 0);
+    std::fill(distanceFrequencies, distanceFrequencies + kDistanceCodes, 0);
+}
+
+void SSDeflater::putBits(uint32_t value, int count) {
+    bitBuffer |= static_cast<uint64_t>(value) << bitCount;
+    bitCount += count;
+
+    if (bitCount >= 32) {
+        const uint32_t word = static_cast<uint32_t>(bitBuffer);
+        const uint8_t bytes[4] = {
+            static_cast<uint8_t>(word), static_cast<uint8_t>(word >> 8),
+            static_cast<uint8_t>(word >> 16), static_cast<uint8_t>(word >> 24)
+        };
+        out.insert(out.end(), bytes, bytes + 4);
+
+        bitBuffer >>= 32;
+        bitCount -= 32;
+    }
+}
+
+/// Flush the partial byte, padded with zero bits
+void SSDeflater::alignToByte() {
+    while (bitCount > 0) {
+        out.push_back(static_cast<uint8_t>(bitBuffer));
+        bitBuffer >>= 8;
+        bitCount -= 8;
+    }
+
+    bitBuffer = 0;
+    bitCount = 0;
+}
+
+// MARK: Adler-32
+
+static constexpr uint32_t kAdlerModulus = 65521;
+
+/// Update a zlib Adler-32 checksum (start from 1) with size more bytes.
+uint32_t SSAdler32(uint32_t adler, const uint8_t data[], size_t size) {
+    // Largest run of bytes whose sums can't overflow 32 bits before taking the modulus
+    constexpr size_t kMaxRun = 5552;
+    constexpr uint32_t kModulus = kAdlerModulus;
+
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+
+    while (size > 0) {
+        const size_t run = std::min(size, kMaxRun);
+
+        for (size_t i = 0; i < run; i++) {
+            a += data[i];
+            b += a;
+        }
+
+        a %= kModulus;
+        b %= kModulus;
+        data += run;
+        size -= run;
+    }
+
+    return (b << 16) | a;
+}
+
+/// The Adler-32 of two byte strings one after the other.
+///
+/// The first sum just adds up. Each byte of the first string is counted secondSize more times
+/// in the second sum, which adds secondSize * (first's first sum - 1) on top of both second
+/// sums (the -1 because both checksums started their first sum at 1).
+uint32_t SSAdler32Combine(uint32_t first, uint32_t second, size_t secondSize) {
+    const uint32_t remainder = secondSize % kAdlerModulus;
+
+    uint32_t sum1 = first & 0xFFFF;
+    uint32_t sum2 = (remainder * sum1) % kAdlerModulus;
+
+    sum1 += (second & 0xFFFF) + kAdlerModulus - 1;
+    sum2 += (first >> 16) + (second >> 16) + kAdlerModulus - remainder;
+
+    if (sum1 >= kAdlerModulus) sum1 -= kAdlerModulus;
+    if (sum1 >= kAdlerModulus) sum1 -= kAdlerModulus;
+    if (sum2 >= 2 * kAdlerModulus) sum2 -= 2 * kAdlerModulus;
+    if (sum2 >= kAdlerModulus) sum2 -= kAdlerModulus;
+
+    return (sum2 << 16) | sum1;
+}
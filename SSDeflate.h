@@ -0,0 +1,113 @@
+#ifndef SSDeflate_DEFINED
+#define SSDeflate_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// How hard SSDeflater works to make its output small.
+enum class SSCompression {
+    /// Stored blocks only: no compression, as fast as a copy
+    kStore,
+
+    /// Greedy matching on a short hash chain. Most of kBest's ratio on rendered images at a
+    /// fraction of the time
+    kFast,
+
+    /// Lazy matching on long hash chains (zlib's level 9)
+    kBest,
+};
+
+/// A streaming raw DEFLATE (RFC 1951) compressor. Data goes in with any number of write() calls
+/// and compressed bytes are appended to the output vector as blocks fill up, so the caller never
+/// has to hold the whole input.
+///
+/// Each block is written with fixed or dynamic Huffman codes, whichever is smaller.
+class SSDeflater {
+public:
+    SSDeflater(SSCompression compression, std::vector<uint8_t>& out);
+
+    SSDeflater(const SSDeflater&) = delete;
+    SSDeflater& operator=(const SSDeflater&) = delete;
+
+    /// Compress size more bytes.
+    void write(const uint8_t data[], size_t size);
+
+    /// Compress whatever is still buffered and end the stream with a final block, padded to a
+    /// whole byte. Nothing may be written afterwards.
+    ///
+    /// With isLast false the blocks written are not final and the output ends on a byte
+    /// boundary (an empty stored block, zlib's sync flush), so another deflater's output can be
+    /// appended to continue the same stream. That is how bands compressed on separate threads
+    /// are joined.
+    void finish(bool isLast = true);
+
+private:
+    struct Match {
+        uint32_t length;
+        uint32_t distance;
+    };
+
+    /// A literal (distance == 0) or a length/distance pair
+    struct Symbol {
+        uint16_t literalOrLength;
+        uint16_t distance;
+    };
+
+    /// Drop input that is out of the match window, to make room at the end of the buffer
+    void makeRoom();
+
+    /// Emit stored blocks for buffered input, leaving less than a full block unless finishing.
+    /// When finishing, the last block is final if isLast.
+    void storeBuffered(bool finishing, bool isLast = true);
+
+    /// Turn buffered input before limit (an absolute position) into symbols
+    void compressGreedy(uint32_t limit);
+    void compressLazy(uint32_t limit);
+
+    Match findMatch(uint32_t position);
+    void insertHash(uint32_t position);
+
+    void emitLiteral(uint8_t literal);
+    void emitMatch(const Match& match);
+
+    /// Huffman code the queued symbols as one block
+    void writeBlock(bool isFinal);
+
+    void putBits(uint32_t value, int count);
+    void alignToByte();
+
+    const SSCompression compression;
+    std::vector<uint8_t>& out;
+
+    /// Unflushed output bits, least significant first
+    uint64_t bitBuffer = 0;
+    int bitCount = 0;
+
+    /// Input: the match window followed by data not compressed yet. Positions are offsets into
+    /// buffer, rebased by makeRoom(), and position is the next byte to compress.
+    std::vector<uint8_t> buffer;
+    uint32_t bufferEnd = 0;
+    uint32_t position = 0;
+
+    /// Hash chains: head[hash] is the latest position + 1 with that hash (0 for none), and
+    /// previous[position % window] the one before it
+    std::vector<uint32_t> head;
+    std::vector<uint32_t> previous;
+
+    /// kBest's match at position - 1, held back in case position has a longer one
+    Match pending = { 0, 0 };
+
+    std::vector<Symbol> symbols;
+    uint32_t literalFrequencies[286] = {};
+    uint32_t distanceFrequencies[30] = {};
+};
+
+/// Update a zlib Adler-32 checksum (start from 1) with size more bytes.
+uint32_t SSAdler32(uint32_t adler, const uint8_t data[], size_t size);
+
+/// The Adler-32 of two byte strings one after the other, from each one's checksum and the
+/// second's length (zlib's adler32_combine).
+uint32_t SSAdler32Combine(uint32_t first, uint32_t second, size_t secondSize);
+
+#endif // SSDeflate_DEFINED
@@ -2,6 +2,8 @@
 #define SSEdge_DEFINED
 
 #include "include/GTypes.h"
+#include "SSArena.h"
+#include "SSStats.h"
 
 /// Find m and b (x = my + b) from two points
 static inline void find_m_and_b(const GPoint& p0, const GPoint& p1, float& m, float& b) {
@@ -67,8 +69,11 @@ struct SSEdge {
     }
 };
 
-static inline void appendEdgeIfValid(const SSEdge& edge, std::vector<SSEdge>& edges) {
-    if (edge.isValid) edges.push_back(edge);
+static inline void appendEdgeIfValid(const SSEdge& edge, SSArenaArray<SSEdge>& edges) {
+    if (!edge.isValid) return;
+
+    edges.push_back(edge);
+    SS_STAT_ADD(edgesBuilt, 1);
 }
 
 static inline float find_corresponding_x(const GPoint& p0, const GPoint& p1, const float& target_y) {
@@ -89,15 +94,21 @@ static inline float find_corresponding_y(const GPoint& p0, const GPoint& p1, con
     return p0.y + (target_x - p0.x) / m;
 }
 
-static inline void lineSegmentToEdges(GPoint p0, GPoint p1, const GRect& bounds, std::vector<SSEdge>& edges) {
+static inline void lineSegmentToEdges(GPoint p0, GPoint p1, const GRect& bounds, SSArenaArray<SSEdge>& edges) {
     // Ignore line if it is completely below or above bounds
     bool completely_above = p0.y < bounds.top && p1.y < bounds.top;
     bool completely_below = p0.y > bounds.bottom && p1.y > bounds.bottom;
 
     if (completely_above || completely_below) {
+        SS_STAT_ADD(edgesClipped, 1);
         return;
     }
 
+    // Count the lines that need chopping below
+    SS_STAT_ADD(edgesClipped,
+        std::min(p0.x, p1.x) < bounds.left || std::max(p0.x, p1.x) > bounds.right ||
+        std::min(p0.y, p1.y) < bounds.top || std::max(p0.y, p1.y) > bounds.bottom);
+
     // Calculate winding value early
     int winding;
 
@@ -196,10 +207,7 @@ static inline bool compareEdges(const SSEdge& l, const SSEdge& r) {
     return l.top < r.top;
 }
 
-static inline std::vector<SSEdge> makeEdges(const GPoint points[], const int& count, const GRect& bounds) {
-    std::vector<SSEdge> edges = {};
-    edges.reserve(count * 2);
-
+static inline void makeEdges(const GPoint points[], const int& count, const GRect& bounds, SSArenaArray<SSEdge>& edges) {
     for (int i = 0; i < count; i++) {
         GPoint p0 = points[i];
         GPoint p1 = points[i == count - 1 ? 0 : i + 1];
@@ -207,8 +215,6 @@ static inline std::vector<SSEdge> makeEdges(const GPoint points[], const int& co
     }
 
     std::sort(edges.begin(), edges.end(), compareEdges);
-
-    return edges;
 }
 
 static inline float SSEdge_yIntersection(const SSEdge& edge, const float& y) {
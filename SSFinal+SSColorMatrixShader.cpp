@@ -2,12 +2,25 @@
 
 #include "include/GShader.h"
 #include "SSBlendModeHelpers.h"
+#include "SSShader.h"
 #include "GColorShader+SSHelpers.h"
 
-class SSColorMatrixShader : public GShader {
+class SSColorMatrixShader : public SSShader {
 private:
-    const GColorMatrix& colorMatrix;
+    const GColorMatrix colorMatrix;
     GShader *shader;
+    SSPipeline pipeline;
+
+    /// Unpremultiply src, transform it by the color matrix, and premultiply it again.
+    static void colorMatrixStage(SSPipelineRegisters& registers, void* context) {
+        const GColorMatrix& colorMatrix = static_cast<SSColorMatrixShader*>(context)->colorMatrix;
+
+        for (int i = 0; i < registers.count; i++) {
+            GColor baseColor = pixelToColor(registers.src[i]);
+            GColor newColor = colorMatrix * baseColor;
+            registers.src[i] = colorToPixel(newColor);
+        }
+    }
 
 public:
     SSColorMatrixShader(
@@ -16,7 +29,17 @@ public:
     ) 
         : colorMatrix(colorMatrix)
         , shader(shader)
-    {}
+    {
+        // Fuse the real shader's stages and the color matrix into one pipeline
+        appendStages(pipeline);
+
+        // Deeply nested shaders can run out of stages: shade the real shader on its own instead
+        if (pipeline.hasOverflowed()) {
+            pipeline.reset();
+            pipeline.append(SSPipelineStage_shadeRow, shader);
+            pipeline.append(colorMatrixStage, this);
+        }
+    }
 
     /// Return true iff all of the GPixels that may be returned by this shader will be opaque.
     bool isOpaque() override {
@@ -33,18 +56,13 @@ public:
     /// corresponding src pixels in row[0...count - 1]. The caller must ensure that row[]
     /// can hold at least [count] entries.
     void shadeRow(int x, int y, int count, GPixel row[]) override {
-        GPixel baseRow[count];
-        shader->shadeRow(x, y, count, baseRow);
-
-        for (int i = 0; i < count; i++) {
-            // Read base color from shaded row
-            GPixel basePixel = baseRow[i];
-            GColor baseColor = pixelToColor(basePixel);
+        pipeline.run(x, y, count, row);
+    }
 
-            // Transform color by color matrix
-            GColor newColor = colorMatrix * baseColor;
-            row[i] = colorToPixel(newColor);
-        }
+    /// real shader stages -> color matrix
+    void appendStages(SSPipeline& pipeline) override {
+        SSShader_appendStages(pipeline, shader);
+        pipeline.append(colorMatrixStage, this);
     }
 };
 
@@ -0,0 +1,138 @@
+#include "SSFinal.h"
+
+#include "include/GCanvas.h"
+#include "GPoint+SSHelpers.h"
+#include "SSCanvas.h"
+#include "SSQuadTessellation.h"
+
+/// Largest distance, in device pixels, the flat triangles may stray from the true patch
+const float kCoonsTolerance = 0.25f;
+
+/// Evaluate the quadratic bezier p0, p1, p2 at count evenly spaced t in [0, 1], by forward
+/// differencing. The last sample is pinned to p2, so neighboring patches meet exactly.
+static void evaluateQuadratic(GPoint p0, GPoint p1, GPoint p2, int count, GPoint out[]) {
+    // Q(t) = A*t^2 + B*t + C
+    const GPoint A = p0 - 2 * p1 + p2;
+    const GPoint B = 2 * (p1 - p0);
+    const float h = 1.0f / (count - 1);
+
+    GPoint point = p0;
+    GPoint firstDifference = (h * h) * A + h * B;
+    const GPoint secondDifference = (2 * h * h) * A;
+
+    for (int i = 0; i < count - 1; i++) {
+        out[i] = point;
+        point += firstDifference;
+        firstDifference += secondDifference;
+    }
+
+    out[count - 1] = p2;
+}
+
+/// Lowest level, no more than maxLevel, at which the tessellated patch stays within
+/// kCoonsTolerance of the real one.
+///
+/// A quadratic strays at most |p0 - 2*p1 + p2| / 4 from its chord, and split into n pieces each
+/// strays 1/n^2 as far. The interior can't bend more than its sides plus the twist of its corners,
+/// which is measured the same way.
+static int coonsLevel(const GPoint devicePts[8], int maxLevel) {
+    auto deviation = [](GPoint p0, GPoint p1, GPoint p2) {
+        GPoint d = p0 - 2 * p1 + p2;
+        return 0.25f * sqrtf(d.x * d.x + d.y * d.y);
+    };
+
+    float maxDeviation = std::max({
+        deviation(devicePts[0], devicePts[1], devicePts[2]),
+        deviation(devicePts[2], devicePts[3], devicePts[4]),
+        deviation(devicePts[4], devicePts[5], devicePts[6]),
+        deviation(devicePts[6], devicePts[7], devicePts[0]),
+    });
+
+    GPoint twist = devicePts[0] - devicePts[2] + devicePts[4] - devicePts[6];
+    maxDeviation = std::max(maxDeviation, 0.25f * sqrtf(twist.x * twist.x + twist.y * twist.y));
+
+    // Clamp to [1, maxLevel + 1] before converting, so huge deviations can't overflow the int.
+    // Written so that NaN (from non-finite points) falls back to maxLevel too.
+    double segments = ceilf(sqrtf(maxDeviation / kCoonsTolerance));
+    if (!(segments <= maxLevel + 1.0)) segments = maxLevel + 1.0;
+    segments = std::max(1.0, segments);
+
+    return static_cast<int>(segments - 1);
+}
+
+/// Draw the quadratic Coons patch with control points pts (see GFinal), texture coordinates
+/// tex at its corners, tessellated at no more than level.
+///
+/// The level actually used comes from how far the patch, mapped by the canvas' CTM, bends
+/// away from flat: small or nearly flat patches are drawn with few triangles.
+void SSFinal::drawQuadraticCoons(
+    GCanvas* canvas,
+    const GPoint pts[8],
+    const GPoint tex[4],
+    int level,
+    const GPaint& paint
+) {
+    // Measure flatness in device space, and build the mesh in the canvas' scratch memory.
+    // Canvases other than ours can't tell us their CTM, so they get the level they asked for.
+    level = std::max(0, level);
+
+    static thread_local SSArena fallbackArena;
+    SSArena* arena = &fallbackArena;
+
+    if (SSCanvas* ssCanvas = dynamic_cast<SSCanvas*>(canvas)) {
+        GPoint devicePts[8];
+        ssCanvas->getCTM().mapPoints(devicePts, pts, 8);
+        level = coonsLevel(devicePts, level);
+        arena = &ssCanvas->scratchArena();
+    }
+
+    SSArenaScope scratch(*arena);
+
+    const int samplesPerSide = level + 2;
+    const int subQuadsPerSide = level + 1;
+
+    // Boundary curves, each sampled left -> right or top -> bottom
+    GPoint* top = arena->allocate<GPoint>(samplesPerSide);
+    GPoint* bottom = arena->allocate<GPoint>(samplesPerSide);
+    GPoint* left = arena->allocate<GPoint>(samplesPerSide);
+    GPoint* right = arena->allocate<GPoint>(samplesPerSide);
+
+    evaluateQuadratic(pts[0], pts[1], pts[2], samplesPerSide, top);
+    evaluateQuadratic(pts[6], pts[5], pts[4], samplesPerSide, bottom);
+    evaluateQuadratic(pts[0], pts[7], pts[6], samplesPerSide, left);
+    evaluateQuadratic(pts[2], pts[3], pts[4], samplesPerSide, right);
+
+    // value(u, v) = TB(u, v) + LR(u, v) - Corners(u, v), with Corners from the bilinear grid
+    const GPoint corners[4] = { pts[0], pts[2], pts[4], pts[6] };
+
+    GPoint* vertices = arena->allocate<GPoint>(samplesPerSide * samplesPerSide);
+    GPoint* texturePoints = arena->allocate<GPoint>(samplesPerSide * samplesPerSide);
+
+    SSFillBilinearGrid(corners, samplesPerSide, vertices);
+    SSFillBilinearGrid(tex, samplesPerSide, texturePoints);
+
+    const float steps = samplesPerSide - 1;
+
+    for (int row = 0; row < samplesPerSide; row++) {
+        float v = row / steps;
+
+        for (int col = 0; col < samplesPerSide; col++) {
+            float u = col / steps;
+
+            GPoint topBottom = (1 - v) * top[col] + v * bottom[col];
+            GPoint leftRight = (1 - u) * left[row] + u * right[row];
+
+            GPoint& vertex = vertices[row * samplesPerSide + col];
+            vertex = topBottom + leftRight - vertex;
+        }
+    }
+
+    canvas->drawMesh(
+        vertices,
+        nullptr,
+        texturePoints,
+        subQuadsPerSide * subQuadsPerSide * 2,
+        SSQuadIndices(level, *arena),
+        paint
+    );
+}
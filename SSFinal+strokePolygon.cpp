@@ -0,0 +1,48 @@
+#include "SSFinal.h"
+
+#include "include/GPathBuilder.h"
+#include "SSStroker.h"
+
+/// Construct a path that, when drawn, will look like a stroke of the specified polygon.
+/// - count is the number of points in the polygon (it will be >= 2)
+/// - width is the thickness of the stroke that should be centered on the polygon edges
+/// - isClosed specifies if the polygon should appear closed (true) or open (false).
+///
+/// Any caps or joins needed should be round (circular).
+///
+/// The path is one contour per segment rectangle and per round join or cap, all wound the same
+/// way, so non-zero winding fills their union. The joins are polygons rather than curves, so
+/// drawing the path has nothing to flatten. SSCanvas::strokePolygon draws the same pieces
+/// without building a path at all.
+std::shared_ptr<GPath> SSFinal::strokePolygon(
+    const GPoint pts[],
+    int count,
+    float width,
+    bool isClosed
+) {
+    const float radius = width / 2;
+
+    // The path doesn't know the CTM it will be drawn with, so joins are sized for identity
+    const int circleSegments = SSStrokerCircleSegments(radius);
+
+    GPathBuilder builder;
+
+    const GPoint* unitCircle = SSStrokerUnitCircle(circleSegments);
+    GPoint circle[kSSStrokerMaxCircleSegments];
+
+    auto addSegment = [&](const GPoint quad[4]) {
+        builder.addPolygon(quad, 4);
+    };
+
+    auto addJoin = [&](GPoint center) {
+        for (int i = 0; i < circleSegments; i++) {
+            circle[i] = center + radius * unitCircle[i];
+        }
+
+        builder.addPolygon(circle, circleSegments);
+    };
+
+    SSStrokerForEachPiece(pts, count, radius, isClosed, addSegment, addJoin);
+
+    return builder.detach();
+}
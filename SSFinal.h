@@ -54,6 +54,32 @@ class SSFinal : public GFinal {
         const GColor colors[],
         int count
     );
+
+    /// Construct a path that, when drawn, will look like a stroke of the specified polygon.
+    /// - count is the number of points in the polygon (it will be >= 2)
+    /// - width is the thickness of the stroke that should be centered on the polygon edges
+    /// - isClosed specifies if the polygon should appear closed (true) or open (false).
+    ///
+    /// Any caps or joins needed should be round (circular).
+    virtual std::shared_ptr<GPath> strokePolygon(
+        const GPoint[],
+        int count,
+        float width,
+        bool isClosed
+    );
+
+    /// Draw the quadratic Coons patch with control points pts (see GFinal), texture coordinates
+    /// tex at its corners, tessellated at no more than level.
+    ///
+    /// The level actually used comes from how far the patch, mapped by the canvas' CTM, bends
+    /// away from flat: small or nearly flat patches are drawn with few triangles.
+    virtual void drawQuadraticCoons(
+        GCanvas*,
+        const GPoint pts[8],
+        const GPoint tex[4],
+        int level,
+        const GPaint&
+    );
 };
 
 #endif
\ No newline at end of file
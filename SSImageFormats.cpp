@@ -0,0 +1,509 @@
+#include "SSImageFormats.h"
+#include "SSPremul.h"
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the .gbitmap header is written as it sits in memory");
+
+/// The format for a path's extension (case insensitive)
+SSImageFormat SSImageFormat_fromPath(const char path[]) {
+    const char* dot = strrchr(path, '.');
+    if (!dot) return SSImageFormat::kPNG;
+
+    std::string extension(dot + 1);
+    for (char& c : extension) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+
+    if (extension == "qoi") return SSImageFormat::kQOI;
+    if (extension == "pam") return SSImageFormat::kPAM;
+    if (extension == "ppm") return SSImageFormat::kPPM;
+    if (extension == "gbitmap") return SSImageFormat::kNative;
+    return SSImageFormat::kPNG;
+}
+
+// MARK: Files
+
+static bool readFile(const char path[], std::vector<uint8_t>& data) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    bool success = fseek(file, 0, SEEK_END) == 0;
+    const long size = success ? ftell(file) : -1;
+    success = success && size >= 0 && fseek(file, 0, SEEK_SET) == 0;
+
+    if (success) {
+        data.resize(size);
+        success = fread(data.data(), 1, size, file) == static_cast<size_t>(size);
+    }
+
+    fclose(file);
+    return success;
+}
+
+static bool writeFile(const char path[], const std::vector<uint8_t>& data) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    const bool wrote = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && wrote;
+}
+
+static void appendUInt32BigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    const uint8_t bytes[4] = {
+        static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+        static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)
+    };
+    out.insert(out.end(), bytes, bytes + 4);
+}
+
+static uint32_t readUInt32BigEndian(const uint8_t data[]) {
+    return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3];
+}
+
+/// Premultiplied GPixels as RGB bytes, dropping alpha
+static void packRGBRow(uint8_t dst[], const GPixel src[], int count) {
+    for (int i = 0; i < count; i++) {
+        dst[3 * i + 0] = GPixel_GetR(src[i]);
+        dst[3 * i + 1] = GPixel_GetG(src[i]);
+        dst[3 * i + 2] = GPixel_GetB(src[i]);
+    }
+}
+
+/// RGB bytes as opaque GPixels
+static void unpackRGBRow(GPixel dst[], const uint8_t src[], int count) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = GPixel_PackARGB(255, src[3 * i + 0], src[3 * i + 1], src[3 * i + 2]);
+    }
+}
+
+// MARK: QOI
+
+/// QOI's opcodes (https://qoiformat.org/qoi-specification.pdf). The 2 bit tags sit in the top
+/// bits of the first byte; RGB and RGBA are full bytes that would otherwise be runs of 63 and 64.
+static constexpr uint8_t kQOIIndex = 0x00;
+static constexpr uint8_t kQOIDiff = 0x40;
+static constexpr uint8_t kQOILuma = 0x80;
+static constexpr uint8_t kQOIRun = 0xC0;
+static constexpr uint8_t kQOIRGB = 0xFE;
+static constexpr uint8_t kQOIRGBA = 0xFF;
+static constexpr uint8_t kQOITagMask = 0xC0;
+
+static constexpr size_t kQOIHeaderSize = 14;
+static constexpr uint8_t kQOIEndMarker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+/// Largest image decoded, as in the reference decoder, so a bad header can't ask for gigabytes
+static constexpr uint64_t kQOIMaxPixels = 400000000;
+
+/// A QOI pixel: unpremultiplied r, g, b, a
+struct SSQOIPixel {
+    uint8_t r, g, b, a;
+
+    bool operator==(const SSQOIPixel& other) const {
+        return r == other.r && g == other.g && b == other.b && a == other.a;
+    }
+
+    int hash() const {
+        return (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+    }
+};
+
+/// Append bitmap, encoded as QOI, to out.
+void SSQOI_encode(const GBitmap& bitmap, std::vector<uint8_t>& out) {
+    const int width = bitmap.width();
+    const int height = bitmap.height();
+
+    out.insert(out.end(), { 'q', 'o', 'i', 'f' });
+    appendUInt32BigEndian(out, width);
+    appendUInt32BigEndian(out, height);
+    out.push_back(bitmap.isOpaque() ? 3 : 4);
+    out.push_back(0);
+
+    SSQOIPixel index[64] = {};
+    SSQOIPixel previous = { 0, 0, 0, 255 };
+    int run = 0;
+
+    // One row unpremultiplied, and its encoding: at most 5 bytes a pixel, plus a pending run
+    std::vector<SSQOIPixel> pixels(width);
+    std::vector<uint8_t> encoded(5 * static_cast<size_t>(width) + 1);
+
+    for (int y = 0; y < height; y++) {
+        SSPremul_unpremultiplyRow(reinterpret_cast<uint8_t*>(pixels.data()), bitmap.getAddr(0, y), width);
+        uint8_t* next = encoded.data();
+
+        for (const SSQOIPixel& pixel : pixels) {
+            if (pixel == previous) {
+                if (++run == 62) {
+                    *next++ = kQOIRun | (run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0) {
+                *next++ = kQOIRun | (run - 1);
+                run = 0;
+            }
+
+            const int hash = pixel.hash();
+
+            if (index[hash] == pixel) {
+                *next++ = kQOIIndex | hash;
+            } else if (pixel.a != previous.a) {
+                index[hash] = pixel;
+                *next++ = kQOIRGBA;
+                *next++ = pixel.r;
+                *next++ = pixel.g;
+                *next++ = pixel.b;
+                *next++ = pixel.a;
+            } else {
+                index[hash] = pixel;
+
+                // Differences wrap around, as they do when decoding
+                const int dr = static_cast<int8_t>(pixel.r - previous.r);
+                const int dg = static_cast<int8_t>(pixel.g - previous.g);
+                const int db = static_cast<int8_t>(pixel.b - previous.b);
+                const int drg = dr - dg;
+                const int dbg = db - dg;
+
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *next++ = kQOIDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+                } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                    *next++ = kQOILuma | (dg + 32);
+                    *next++ = ((drg + 8) << 4) | (dbg + 8);
+                } else {
+                    *next++ = kQOIRGB;
+                    *next++ = pixel.r;
+                    *next++ = pixel.g;
+                    *next++ = pixel.b;
+                }
+            }
+
+            previous = pixel;
+        }
+
+        out.insert(out.end(), encoded.data(), next);
+    }
+
+    if (run > 0) out.push_back(kQOIRun | (run - 1));
+    out.insert(out.end(), kQOIEndMarker, kQOIEndMarker + 8);
+}
+
+/// Decode size bytes of QOI into bitmap.
+bool SSQOI_decode(GBitmap* bitmap, const uint8_t data[], size_t size) {
+    if (size < kQOIHeaderSize + sizeof(kQOIEndMarker) || memcmp(data, "qoif", 4) != 0) return false;
+
+    const uint32_t width = readUInt32BigEndian(data + 4);
+    const uint32_t height = readUInt32BigEndian(data + 8);
+    const uint8_t channels = data[12];
+
+    if (width == 0 || height == 0 || (channels != 3 && channels != 4)) return false;
+    if (uint64_t(width) * height > kQOIMaxPixels) return false;
+
+    bitmap->alloc(width, height);
+
+    SSQOIPixel index[64] = {};
+    SSQOIPixel pixel = { 0, 0, 0, 255 };
+    int run = 0;
+
+    const uint8_t* next = data + kQOIHeaderSize;
+    const uint8_t* end = data + size - sizeof(kQOIEndMarker);
+    std::vector<SSQOIPixel> pixels(width);
+
+    for (uint32_t y = 0; y < height; y++) {
+        for (SSQOIPixel& out : pixels) {
+            if (run > 0) {
+                run--;
+            } else {
+                // Every pixel needs a run or an op, so running out early means a truncated stream
+                if (next == end) return false;
+                const uint8_t byte = *next++;
+
+                if (byte == kQOIRGB) {
+                    if (end - next < 3) return false;
+                    pixel.r = next[0];
+                    pixel.g = next[1];
+                    pixel.b = next[2];
+                    next += 3;
+                } else if (byte == kQOIRGBA) {
+                    if (end - next < 4) return false;
+                    pixel = { next[0], next[1], next[2], next[3] };
+                    next += 4;
+                } else if ((byte & kQOITagMask) == kQOIIndex) {
+                    pixel = index[byte];
+                } else if ((byte & kQOITagMask) == kQOIDiff) {
+                    pixel.r += ((byte >> 4) & 3) - 2;
+                    pixel.g += ((byte >> 2) & 3) - 2;
+                    pixel.b += (byte & 3) - 2;
+                } else if ((byte & kQOITagMask) == kQOILuma) {
+                    if (next == end) return false;
+                    const uint8_t second = *next++;
+                    const int dg = (byte & 0x3F) - 32;
+
+                    pixel.r += dg - 8 + ((second >> 4) & 0x0F);
+                    pixel.g += dg;
+                    pixel.b += dg - 8 + (second & 0x0F);
+                } else {
+                    run = byte & 0x3F;
+                }
+
+                index[pixel.hash()] = pixel;
+            }
+
+            out = pixel;
+        }
+
+        SSPremul_premultiplyRow(bitmap->getAddr(0, y), reinterpret_cast<const uint8_t*>(pixels.data()), width);
+    }
+
+    // channels is only informative: the ops can still set alpha, so check what was decoded
+    bitmap->setIsOpaque(GBitmap::kCompute_IsOpaque);
+    return true;
+}
+
+// MARK: Netpbm
+
+/// PAM (P7) or PPM (P6). PAM keeps alpha unless the bitmap is opaque; PPM never does.
+static void encodeNetpbm(const GBitmap& bitmap, bool isPAM, std::vector<uint8_t>& out) {
+    const int width = bitmap.width();
+    const int height = bitmap.height();
+    const bool hasAlpha = isPAM && !bitmap.isOpaque();
+    const int depth = hasAlpha ? 4 : 3;
+
+    char header[128];
+    if (isPAM) {
+        snprintf(header, sizeof(header), "P7\nWIDTH %d\nHEIGHT %d\nDEPTH %d\nMAXVAL 255\nTUPLTYPE %s\nENDHDR\n",
+                 width, height, depth, hasAlpha ? "RGB_ALPHA" : "RGB");
+    } else {
+        snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+    }
+
+    out.insert(out.end(), header, header + strlen(header));
+
+    // Rows are converted straight into out
+    const size_t rowSize = static_cast<size_t>(width) * depth;
+    const size_t start = out.size();
+    out.resize(start + rowSize * height);
+
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = out.data() + start + rowSize * y;
+
+        if (hasAlpha) {
+            SSPremul_unpremultiplyRow(row, bitmap.getAddr(0, y), width);
+        } else {
+            packRGBRow(row, bitmap.getAddr(0, y), width);
+        }
+    }
+}
+
+/// The next header token, skipping whitespace and # comments. Returns false at the end.
+static bool nextToken(const std::vector<uint8_t>& data, size_t& position, std::string& token) {
+    while (position < data.size()) {
+        if (data[position] == '#') {
+            while (position < data.size() && data[position] != '\n') position++;
+        } else if (isspace(data[position])) {
+            position++;
+        } else {
+            break;
+        }
+    }
+
+    token.clear();
+    while (position < data.size() && !isspace(data[position])) {
+        token.push_back(static_cast<char>(data[position++]));
+    }
+
+    return !token.empty();
+}
+
+/// Parse a positive int, or return 0
+static int parseDimension(const std::string& token) {
+    const long value = strtol(token.c_str(), nullptr, 10);
+    return value > 0 && value <= (1 << 20) ? static_cast<int>(value) : 0;
+}
+
+/// Decode a binary PPM (P6) or a PAM (P7) with 8 bit RGB or RGB_ALPHA tuples
+static bool decodeNetpbm(GBitmap* bitmap, const std::vector<uint8_t>& data) {
+    size_t position = 0;
+    std::string token;
+    if (!nextToken(data, position, token)) return false;
+
+    int width = 0, height = 0, depth = 0, maxValue = 0;
+
+    if (token == "P6") {
+        depth = 3;
+        if (!nextToken(data, position, token)) return false;
+        width = parseDimension(token);
+        if (!nextToken(data, position, token)) return false;
+        height = parseDimension(token);
+        if (!nextToken(data, position, token)) return false;
+        maxValue = atoi(token.c_str());
+    } else if (token == "P7") {
+        while (nextToken(data, position, token) && token != "ENDHDR") {
+            std::string value;
+            if (!nextToken(data, position, value)) return false;
+
+            if (token == "WIDTH") width = parseDimension(value);
+            else if (token == "HEIGHT") height = parseDimension(value);
+            else if (token == "DEPTH") depth = atoi(value.c_str());
+            else if (token == "MAXVAL") maxValue = atoi(value.c_str());
+        }
+        if (token != "ENDHDR") return false;
+    } else {
+        return false;
+    }
+
+    // A single whitespace byte separates the header from the pixels
+    position++;
+
+    if (width == 0 || height == 0 || maxValue != 255 || (depth != 3 && depth != 4)) return false;
+
+    const size_t rowSize = static_cast<size_t>(width) * depth;
+    if (position > data.size() || data.size() - position < rowSize * height) return false;
+
+    bitmap->alloc(width, height);
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = data.data() + position + rowSize * y;
+
+        if (depth == 4) {
+            SSPremul_premultiplyRow(bitmap->getAddr(0, y), row, width);
+        } else {
+            unpackRGBRow(bitmap->getAddr(0, y), row, width);
+        }
+    }
+
+    bitmap->setIsOpaque(depth == 3 ? GBitmap::kYes_IsOpaque : GBitmap::kCompute_IsOpaque);
+    return true;
+}
+
+// MARK: Native
+
+/// Whether header describes pixels a GBitmap can point at, all within fileSize bytes
+bool SSNativeHeader_isValid(const SSNativeHeader& header, uint64_t fileSize) {
+    if (memcmp(header.magic, kSSNativeMagic, sizeof(header.magic)) != 0) return false;
+    if (header.version != kSSNativeVersion) return false;
+    if (header.width == 0 || header.width > (1 << 20)) return false;
+    if (header.height == 0 || header.height > (1 << 20)) return false;
+
+    // getAddr steps rows by rowBytes / 4, so rows must hold whole GPixels
+    if (header.rowBytes < uint64_t(header.width) * sizeof(GPixel) || header.rowBytes % sizeof(GPixel) != 0) return false;
+    if (header.pixelOffset < sizeof(header) || header.pixelOffset % sizeof(GPixel) != 0) return false;
+    if (header.rowBytes > fileSize) return false;
+
+    const uint64_t lastRowEnd = (header.height - 1) * header.rowBytes + uint64_t(header.width) * sizeof(GPixel);
+    return header.pixelOffset <= fileSize && lastRowEnd <= fileSize - header.pixelOffset;
+}
+
+/// Header, padding to kSSNativePixelOffset, then the rows with no padding between them
+static bool writeNative(const GBitmap& bitmap, const char path[]) {
+    const size_t rowSize = static_cast<size_t>(bitmap.width()) * sizeof(GPixel);
+
+    SSNativeHeader header = {};
+    memcpy(header.magic, kSSNativeMagic, sizeof(header.magic));
+    header.version = kSSNativeVersion;
+    header.width = bitmap.width();
+    header.height = bitmap.height();
+    header.isOpaque = bitmap.isOpaque();
+    header.rowBytes = rowSize;
+    header.pixelOffset = kSSNativePixelOffset;
+
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    uint8_t page[kSSNativePixelOffset] = {};
+    memcpy(page, &header, sizeof(header));
+    bool wrote = fwrite(page, 1, sizeof(page), file) == sizeof(page);
+
+    if (bitmap.rowBytes() == rowSize) {
+        // One write for the whole pixel block
+        wrote = wrote && fwrite(bitmap.pixels(), rowSize, bitmap.height(), file) == size_t(bitmap.height());
+    } else {
+        for (int y = 0; y < bitmap.height() && wrote; y++) {
+            wrote = fwrite(bitmap.getAddr(0, y), 1, rowSize, file) == rowSize;
+        }
+    }
+
+    return fclose(file) == 0 && wrote;
+}
+
+/// Read the pixels straight into the bitmap's memory: there's nothing to decode
+static bool readNative(GBitmap* bitmap, const char path[]) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    SSNativeHeader header;
+    bool success = fseek(file, 0, SEEK_END) == 0;
+    const long fileSize = success ? ftell(file) : -1;
+
+    success = success && fileSize >= 0 && fseek(file, 0, SEEK_SET) == 0 &&
+        fread(&header, sizeof(header), 1, file) == 1 &&
+        SSNativeHeader_isValid(header, fileSize) &&
+        fseek(file, static_cast<long>(header.pixelOffset), SEEK_SET) == 0;
+
+    if (success) {
+        bitmap->alloc(header.width, header.height);
+        const size_t rowSize = static_cast<size_t>(header.width) * sizeof(GPixel);
+
+        if (header.rowBytes == rowSize) {
+            success = fread(bitmap->pixels(), rowSize, header.height, file) == header.height;
+        } else {
+            for (uint32_t y = 0; y < header.height && success; y++) {
+                success = fread(bitmap->getAddr(0, y), 1, rowSize, file) == rowSize &&
+                    fseek(file, static_cast<long>(header.rowBytes - rowSize), SEEK_CUR) == 0;
+            }
+        }
+
+        // The file's flag is only a claim: verify it rather than let blends skip real alpha
+        bitmap->setIsOpaque(header.isOpaque ? GBitmap::kCompute_IsOpaque : GBitmap::kNo_IsOpaque);
+    }
+
+    fclose(file);
+    return success;
+}
+
+// MARK: Reading and Writing
+
+/// Write bitmap to path in format, which must not be kPNG.
+bool SSImage_writeToFile(const GBitmap& bitmap, const char path[], SSImageFormat format) {
+    std::vector<uint8_t> encoded;
+
+    switch (format) {
+    case SSImageFormat::kPNG:
+        return false;
+    case SSImageFormat::kQOI:
+        SSQOI_encode(bitmap, encoded);
+        return writeFile(path, encoded);
+    case SSImageFormat::kPAM:
+    case SSImageFormat::kPPM:
+        encodeNetpbm(bitmap, format == SSImageFormat::kPAM, encoded);
+        return writeFile(path, encoded);
+    case SSImageFormat::kNative:
+        return writeNative(bitmap, path);
+    }
+
+    return false;
+}
+
+/// Read path, in format (not kPNG), into bitmap.
+bool SSImage_readFromFile(GBitmap* bitmap, const char path[], SSImageFormat format) {
+    if (format == SSImageFormat::kNative) return readNative(bitmap, path);
+
+    std::vector<uint8_t> data;
+    if (!readFile(path, data)) return false;
+
+    switch (format) {
+    case SSImageFormat::kQOI:
+        return SSQOI_decode(bitmap, data.data(), data.size());
+    case SSImageFormat::kPAM:
+    case SSImageFormat::kPPM:
+        return decodeNetpbm(bitmap, data);
+    case SSImageFormat::kPNG:
+    case SSImageFormat::kNative:
+        break;
+    }
+
+    return false;
+}
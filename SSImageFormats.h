@@ -0,0 +1,71 @@
+#ifndef SSImageFormats_DEFINED
+#define SSImageFormats_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "include/GBitmap.h"
+
+/// File formats GBitmap::readFromFile and writeToFile pick between by extension. PNG is the
+/// default, for any extension not listed here.
+enum class SSImageFormat {
+    /// .png
+    kPNG,
+
+    /// .qoi: the Quite OK Image format, lossless and several times faster than PNG both ways
+    kQOI,
+
+    /// .pam: netpbm's RGB_ALPHA (or RGB, for opaque bitmaps) with unpremultiplied colors
+    kPAM,
+
+    /// .ppm: netpbm's binary RGB. There's no alpha, so translucent pixels come out as if drawn
+    /// over black (their premultiplied colors)
+    kPPM,
+
+    /// .gbitmap: premultiplied GPixels exactly as they sit in memory, after a one page header
+    kNative,
+};
+
+/// The format for a path's extension (case insensitive)
+SSImageFormat SSImageFormat_fromPath(const char path[]);
+
+// MARK: Native
+
+/// The .gbitmap header, stored little endian at the start of the file. Pixels start at
+/// pixelOffset (one page in), rowBytes apart, so a reader can map the file and point a GBitmap
+/// straight at them without decoding anything.
+struct SSNativeHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t isOpaque;
+    uint64_t rowBytes;
+    uint64_t pixelOffset;
+};
+
+constexpr char kSSNativeMagic[8] = { 'G', 'B', 'I', 'T', 'M', 'A', 'P', 0 };
+constexpr uint32_t kSSNativeVersion = 1;
+
+/// Where the pixels start: the header padded to a page, for mmap
+constexpr uint64_t kSSNativePixelOffset = 4096;
+
+/// Whether header describes pixels a GBitmap can point at, all within fileSize bytes
+bool SSNativeHeader_isValid(const SSNativeHeader& header, uint64_t fileSize);
+
+// MARK: Reading and Writing
+
+/// Write bitmap to path in format, which must not be kPNG (see SSPNG.h). Returns true on success.
+bool SSImage_writeToFile(const GBitmap& bitmap, const char path[], SSImageFormat format);
+
+/// Read path, in format (not kPNG), into bitmap, allocating its pixels with GBitmap::alloc.
+/// Returns false if the file can't be read or isn't valid.
+bool SSImage_readFromFile(GBitmap* bitmap, const char path[], SSImageFormat format);
+
+/// Append bitmap, encoded as QOI, to out.
+void SSQOI_encode(const GBitmap& bitmap, std::vector<uint8_t>& out);
+
+/// Decode size bytes of QOI into bitmap. Returns false if they aren't valid QOI.
+bool SSQOI_decode(GBitmap* bitmap, const uint8_t data[], size_t size);
+
+#endif // SSImageFormats_DEFINED
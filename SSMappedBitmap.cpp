@@ -0,0 +1,82 @@
+#include "SSMappedBitmap.h"
+#include "SSImageFormats.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Map size bytes of fd, unmapping them when the last reference goes away. The mapping outlives
+/// the descriptor, so fd can be closed straight after.
+static std::shared_ptr<void> mapFile(int fd, size_t size, int flags) {
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (base == MAP_FAILED) return nullptr;
+
+    return std::shared_ptr<void>(base, [size](void* base) { munmap(base, size); });
+}
+
+/// Point bitmap at the pixels described by header, in the file mapped at storage
+static void resetToMapping(GBitmap* bitmap, const SSNativeHeader& header, std::shared_ptr<void> storage) {
+    GPixel* pixels = reinterpret_cast<GPixel*>(static_cast<uint8_t*>(storage.get()) + header.pixelOffset);
+
+    // Not header.isOpaque: claiming opaque makes debug builds validate by reading every page
+    bitmap->reset(header.width, header.height, header.rowBytes, pixels, GBitmap::kNo_IsOpaque, std::move(storage));
+}
+
+bool SSMappedBitmap_create(GBitmap* bitmap, const char path[], int width, int height) {
+    if (width <= 0 || height <= 0) return false;
+
+    SSNativeHeader header = {};
+    memcpy(header.magic, kSSNativeMagic, sizeof(header.magic));
+    header.version = kSSNativeVersion;
+    header.width = width;
+    header.height = height;
+    header.rowBytes = static_cast<uint64_t>(width) * sizeof(GPixel);
+    header.pixelOffset = kSSNativePixelOffset;
+
+    const uint64_t size = header.pixelOffset + header.rowBytes * header.height;
+    if (!SSNativeHeader_isValid(header, size)) return false;
+
+    const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    // Extending the file leaves a hole that reads back as zeros, so the transparent pixels cost
+    // no disk writes until they're drawn
+    std::shared_ptr<void> storage;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        storage = mapFile(fd, size, MAP_SHARED);
+    }
+    close(fd);
+
+    if (!storage) return false;
+
+    memcpy(storage.get(), &header, sizeof(header));
+    resetToMapping(bitmap, header, std::move(storage));
+    return true;
+}
+
+bool SSMappedBitmap_open(GBitmap* bitmap, const char path[], bool writeBack) {
+    const int fd = open(path, writeBack ? O_RDWR : O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat status;
+    SSNativeHeader header;
+
+    // Check the header before mapping anything
+    const bool valid = fstat(fd, &status) == 0 &&
+        pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+        SSNativeHeader_isValid(header, status.st_size);
+
+    std::shared_ptr<void> storage;
+    if (valid) {
+        // A private mapping is charged as if every page will be copied, which fails for files
+        // bigger than memory; only the pages actually drawn on are ever copied
+        storage = mapFile(fd, status.st_size, writeBack ? MAP_SHARED : MAP_PRIVATE | MAP_NORESERVE);
+    }
+    close(fd);
+
+    if (!storage) return false;
+
+    resetToMapping(bitmap, header, std::move(storage));
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef SSMappedBitmap_DEFINED
+#define SSMappedBitmap_DEFINED
+
+#include "include/GBitmap.h"
+
+/// Bitmaps whose pixels live in a .gbitmap file (see SSImageFormats.h) mapped into memory, rather
+/// than in calloc'd memory. The kernel pages rows in as they're drawn and writes them back to the
+/// file as memory gets tight, so a canvas can be far larger than RAM: a 50k x 50k render needs
+/// 10 GB of disk, not 10 GB of memory. Rows stay contiguous, so getAddr and the blitters work
+/// on them unchanged.
+///
+/// The mapping belongs to the bitmap's storage(): it is unmapped once the bitmap, and every
+/// copy of it (a canvas holds one), is reset or destroyed. Don't free() the pixels.
+
+/// Create (or truncate) path as a width x height .gbitmap of transparent pixels and point bitmap
+/// at them. Drawing writes straight through to the file, which is complete once the bitmap is
+/// released. Returns false, leaving bitmap untouched, if the file can't be created or mapped.
+bool SSMappedBitmap_create(GBitmap* bitmap, const char path[], int width, int height);
+
+/// Map an existing .gbitmap file into bitmap. With writeBack, drawing changes the file;
+/// otherwise changed pages are copied on write and the file is left as it was. Returns false,
+/// leaving bitmap untouched, if the file can't be opened or isn't a valid .gbitmap.
+bool SSMappedBitmap_open(GBitmap* bitmap, const char path[], bool writeBack);
+
+#endif // SSMappedBitmap_DEFINED
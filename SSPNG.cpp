@@ -0,0 +1,354 @@
+#include "SSPNG.h"
+#include "SSPremul.h"
+#include "SSTrace.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+// MARK: CRC-32
+
+/// Slicing-by-8 tables for the reflected CRC-32 polynomial PNG uses: table[k][byte] is the CRC
+/// of byte followed by k zero bytes. Built at compile time.
+struct SSCRCTables {
+    uint32_t table[8][256] = {};
+
+    constexpr SSCRCTables() {
+        for (uint32_t byte = 0; byte < 256; byte++) {
+            uint32_t crc = byte;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            table[0][byte] = crc;
+        }
+
+        for (int k = 1; k < 8; k++) {
+            for (int byte = 0; byte < 256; byte++) {
+                const uint32_t previous = table[k - 1][byte];
+                table[k][byte] = (previous >> 8) ^ table[0][previous & 0xFF];
+            }
+        }
+    }
+};
+
+static constexpr SSCRCTables kCRCTables;
+
+/// Update a CRC-32 (start from 0) with size more bytes.
+uint32_t SSCRC32(uint32_t crc, const uint8_t data[], size_t size) {
+    const auto& table = kCRCTables.table;
+    crc = ~crc;
+
+    while (size >= 8) {
+        uint32_t low, high;
+        memcpy(&low, data, 4);
+        memcpy(&high, data + 4, 4);
+        low ^= crc;
+
+        crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^
+              table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+              table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^
+              table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+
+        data += 8;
+        size -= 8;
+    }
+
+    while (size-- > 0) {
+        crc = table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+// MARK: Chunks
+
+/// Largest chunk length PNG allows
+static constexpr size_t kMaxChunkLength = 0x7FFFFFFF;
+
+static void storeUInt32(uint8_t bytes[4], uint32_t value) {
+    bytes[0] = static_cast<uint8_t>(value >> 24);
+    bytes[1] = static_cast<uint8_t>(value >> 16);
+    bytes[2] = static_cast<uint8_t>(value >> 8);
+    bytes[3] = static_cast<uint8_t>(value);
+}
+
+static void appendUInt32(std::vector<uint8_t>& out, uint32_t value) {
+    uint8_t bytes[4];
+    storeUInt32(bytes, value);
+    out.insert(out.end(), bytes, bytes + 4);
+}
+
+/// Pass a chunk of the given type holding size bytes of data to write(bytes, size), which
+/// returns false if it fails
+template <typename WriteFunction>
+static bool writeChunk(WriteFunction& write, const char type[4], const uint8_t data[], size_t size) {
+    assert(size <= kMaxChunkLength);
+
+    uint8_t header[8];
+    storeUInt32(header, static_cast<uint32_t>(size));
+    memcpy(header + 4, type, 4);
+
+    uint8_t crc[4];
+    storeUInt32(crc, SSCRC32(SSCRC32(0, header + 4, 4), data, size));
+
+    return write(header, 8) && (size == 0 || write(data, size)) && write(crc, 4);
+}
+
+// MARK: Filters
+
+/// PNG's row filters, by their type byte
+enum class SSPNGFilter : uint8_t {
+    kNone,
+    kSub,
+    kUp,
+    kAverage,
+    kPaeth,
+};
+
+static inline uint8_t paethPredictor(int left, int up, int upLeft) {
+    const int estimate = left + up - upLeft;
+    const int toLeft = abs(estimate - left);
+    const int toUp = abs(estimate - up);
+    const int toUpLeft = abs(estimate - upLeft);
+
+    if (toLeft <= toUp && toLeft <= toUpLeft) return left;
+    return toUp <= toUpLeft ? up : upLeft;
+}
+
+/// Filter row (size bytes, bpp per pixel) against prior, the row above it, into out: the filter
+/// type byte followed by size filtered bytes.
+static void filterRow(SSPNGFilter filter, const uint8_t row[], const uint8_t prior[], size_t size, int bpp, uint8_t out[]) {
+    out[0] = static_cast<uint8_t>(filter);
+    out += 1;
+
+    switch (filter) {
+    case SSPNGFilter::kNone:
+        memcpy(out, row, size);
+        break;
+    case SSPNGFilter::kSub:
+        for (size_t i = 0; i < size; i++) {
+            out[i] = row[i] - (i >= size_t(bpp) ? row[i - bpp] : 0);
+        }
+        break;
+    case SSPNGFilter::kUp:
+        for (size_t i = 0; i < size; i++) {
+            out[i] = row[i] - prior[i];
+        }
+        break;
+    case SSPNGFilter::kAverage:
+        for (size_t i = 0; i < size; i++) {
+            const int left = i >= size_t(bpp) ? row[i - bpp] : 0;
+            out[i] = row[i] - ((left + prior[i]) >> 1);
+        }
+        break;
+    case SSPNGFilter::kPaeth:
+        for (size_t i = 0; i < size; i++) {
+            const int left = i >= size_t(bpp) ? row[i - bpp] : 0;
+            const int upLeft = i >= size_t(bpp) ? prior[i - bpp] : 0;
+            out[i] = row[i] - paethPredictor(left, prior[i], upLeft);
+        }
+        break;
+    }
+}
+
+/// libpng's filter heuristic: the sum of the filtered bytes as signed magnitudes
+static uint64_t filterCost(const uint8_t filtered[], size_t size) {
+    uint64_t cost = 0;
+    for (size_t i = 0; i < size; i++) {
+        cost += abs(static_cast<int8_t>(filtered[i]));
+    }
+    return cost;
+}
+
+// MARK: Encoding
+
+static bool isOpaque(const GBitmap& bitmap) {
+    for (int y = 0; y < bitmap.height(); y++) {
+        if (!SSPremul_isOpaqueRow(bitmap.getAddr(0, y), bitmap.width())) return false;
+    }
+
+    return true;
+}
+
+/// Bitmap row y as PNG bytes: RGB for opaque bitmaps, otherwise unpremultiplied RGBA
+static void convertRow(const GBitmap& bitmap, int y, bool opaque, uint8_t out[]) {
+    const GPixel* row = bitmap.getAddr(0, y);
+
+    if (!opaque) {
+        SSPremul_unpremultiplyRow(out, row, bitmap.width());
+        return;
+    }
+
+    for (int x = 0; x < bitmap.width(); x++) {
+        out[3 * x + 0] = GPixel_GetR(row[x]);
+        out[3 * x + 1] = GPixel_GetG(row[x]);
+        out[3 * x + 2] = GPixel_GetB(row[x]);
+    }
+}
+
+/// Filter and deflate rows [top, bottom) into out, returning the Adler-32 of the filtered bytes.
+/// The row above top is read too, as the prior row of the first; the output ends the zlib
+/// stream only if isLast.
+static uint32_t deflateRows(
+    const GBitmap& bitmap,
+    bool opaque,
+    SSCompression compression,
+    int top,
+    int bottom,
+    bool isLast,
+    std::vector<uint8_t>& out
+) {
+    SSTraceZone zone("png.deflate");
+
+    const int bpp = opaque ? 3 : 4;
+    const size_t rowSize = static_cast<size_t>(bitmap.width()) * bpp;
+
+    // The row above (zeros for the first), this row, and a filtered row per candidate filter
+    std::vector<uint8_t> rows(2 * rowSize, 0);
+    std::vector<uint8_t> filtered(5 * (rowSize + 1));
+    uint8_t* prior = rows.data();
+    uint8_t* current = rows.data() + rowSize;
+
+    if (top > 0) convertRow(bitmap, top - 1, opaque, prior);
+
+    SSDeflater deflater(compression, out);
+    uint32_t adler = 1;
+
+    for (int y = top; y < bottom; y++) {
+        convertRow(bitmap, y, opaque, current);
+
+        const uint8_t* best = filtered.data();
+
+        if (compression == SSCompression::kStore) {
+            filterRow(SSPNGFilter::kNone, current, prior, rowSize, bpp, filtered.data());
+        } else if (compression == SSCompression::kFast) {
+            filterRow(y == 0 ? SSPNGFilter::kSub : SSPNGFilter::kUp, current, prior, rowSize, bpp, filtered.data());
+        } else {
+            uint64_t bestCost = UINT64_MAX;
+
+            for (int filter = 0; filter < 5; filter++) {
+                uint8_t* candidate = filtered.data() + filter * (rowSize + 1);
+                filterRow(static_cast<SSPNGFilter>(filter), current, prior, rowSize, bpp, candidate);
+
+                const uint64_t cost = filterCost(candidate + 1, rowSize);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    best = candidate;
+                }
+            }
+        }
+
+        deflater.write(best, rowSize + 1);
+        adler = SSAdler32(adler, best, rowSize + 1);
+
+        std::swap(prior, current);
+    }
+
+    deflater.finish(isLast);
+    return adler;
+}
+
+/// Encode bitmap as a PNG, passing it to write(bytes, size) piece by piece in order. write
+/// returns false if it fails, which stops encoding.
+template <typename WriteFunction>
+static bool writePNG(const GBitmap& bitmap, SSCompression compression, int threadCount, WriteFunction write) {
+    SSTraceZone zone("png.encode");
+
+    const int width = bitmap.width();
+    const int height = bitmap.height();
+    if (width <= 0 || height <= 0) return false;
+
+    const bool opaque = isOpaque(bitmap);
+    const size_t filteredRowSize = static_cast<size_t>(width) * (opaque ? 3 : 4) + 1;
+
+    static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (!write(kSignature, 8)) return false;
+
+    // IHDR: 8 bit RGB (2) or RGBA (6), no interlacing
+    uint8_t header[13] = { 0, 0, 0, 0, 0, 0, 0, 0, 8, static_cast<uint8_t>(opaque ? 2 : 6), 0, 0, 0 };
+    storeUInt32(header, width);
+    storeUInt32(header + 4, height);
+    if (!writeChunk(write, "IHDR", header, 13)) return false;
+
+    // Enough bands that none holds more than kSSPNGMaxBandBytes of filtered rows, and one per
+    // thread as long as each still gets kSSPNGMinBandBytes
+    if (threadCount <= 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    const size_t filteredSize = filteredRowSize * height;
+    const size_t bandsBySize = std::max<size_t>(1, filteredSize / kSSPNGMinBandBytes);
+    const size_t bandsByMemory = (filteredSize + kSSPNGMaxBandBytes - 1) / kSSPNGMaxBandBytes;
+    const size_t bands = std::max(bandsByMemory, std::min<size_t>(size_t(threadCount), bandsBySize));
+    const int bandCount = static_cast<int>(std::min<size_t>(bands, size_t(height)));
+
+    auto bandTop = [&](int band) {
+        return static_cast<int>(static_cast<int64_t>(height) * band / bandCount);
+    };
+
+    // The zlib stream: a header whose level hint is 0 (fastest), 1 (fast) or 3 (best), the
+    // bands' deflate streams joined at byte boundaries, and the Adler-32 of all filtered rows
+    const uint8_t zlibLevel = compression == SSCompression::kStore ? 0x01 : (compression == SSCompression::kFast ? 0x5E : 0xDA);
+    uint32_t adler = 1;
+
+    // Bands are deflated threadCount at a time, the first of each wave on this thread and the
+    // rest on workers, and each is written as an IDAT chunk of its own as soon as the ones
+    // before it are. Only one wave's compressed bands are ever held, and no chunk comes close
+    // to PNG's 2^31 byte limit.
+    for (int first = 0; first < bandCount; first += threadCount) {
+        const int last = std::min(bandCount, first + threadCount);
+
+        std::vector<std::vector<uint8_t>> bandOutputs(last - first);
+        std::vector<uint32_t> bandAdlers(last - first);
+        if (first == 0) bandOutputs[0] = { 0x78, zlibLevel };
+
+        auto deflateBand = [&](int band) {
+            bandAdlers[band - first] = deflateRows(bitmap, opaque, compression, bandTop(band), bandTop(band + 1), band == bandCount - 1, bandOutputs[band - first]);
+        };
+
+        std::vector<std::thread> workers;
+        for (int band = first + 1; band < last; band++) {
+            workers.emplace_back(deflateBand, band);
+        }
+
+        deflateBand(first);
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        for (int band = first; band < last; band++) {
+            std::vector<uint8_t>& bandOutput = bandOutputs[band - first];
+
+            const size_t bandSize = filteredRowSize * (bandTop(band + 1) - bandTop(band));
+            adler = band == 0 ? bandAdlers[0] : SSAdler32Combine(adler, bandAdlers[band - first], bandSize);
+
+            if (band == bandCount - 1) appendUInt32(bandOutput, adler);
+            if (!writeChunk(write, "IDAT", bandOutput.data(), bandOutput.size())) return false;
+
+            std::vector<uint8_t>().swap(bandOutput);
+        }
+    }
+
+    return writeChunk(write, "IEND", nullptr, 0);
+}
+
+/// Append bitmap, encoded as a PNG, to out.
+bool SSPNG_writeToMemory(const GBitmap& bitmap, std::vector<uint8_t>& out, SSCompression compression, int threadCount) {
+    return writePNG(bitmap, compression, threadCount, [&out](const uint8_t data[], size_t size) {
+        out.insert(out.end(), data, data + size);
+        return true;
+    });
+}
+
+/// Encode bitmap and write it to a new file at path, chunk by chunk.
+bool SSPNG_writeToFile(const GBitmap& bitmap, const char path[], SSCompression compression, int threadCount) {
+    if (bitmap.width() <= 0 || bitmap.height() <= 0) return false;
+
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    const bool wrote = writePNG(bitmap, compression, threadCount, [file](const uint8_t data[], size_t size) {
+        return fwrite(data, 1, size, file) == size;
+    });
+
+    return fclose(file) == 0 && wrote;
+}
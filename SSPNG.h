@@ -0,0 +1,52 @@
+#ifndef SSPNG_DEFINED
+#define SSPNG_DEFINED
+
+#include <cstdint>
+#include <vector>
+#include "include/GBitmap.h"
+#include "SSDeflate.h"
+
+/// PNG encoding straight from GPixel rows: each row is unpremultiplied, filtered and fed to an
+/// SSDeflater. Nothing full size is buffered: SSPNG_writeToFile streams the PNG to the file one
+/// IDAT chunk at a time, so bitmaps larger than RAM (see SSMappedBitmap) can be saved.
+///
+/// The compression setting picks the filters as well as the deflate effort:
+///     kStore  no filter, stored blocks (fastest, largest)
+///     kFast   the Up filter on every row, greedy matching
+///     kBest   each row's best filter by libpng's sum of absolute differences, lazy matching
+///
+/// Opaque bitmaps are written as RGB, others as RGBA, 8 bits per component.
+///
+/// Large bitmaps are split into bands of rows, deflated several at a time on their own threads,
+/// each into a piece of the one zlib stream in an IDAT chunk of its own; the pieces are joined at
+/// byte boundaries and their Adler-32s combined. Bands don't share a match window, which costs a
+/// little size at each seam.
+
+/// Smallest band of filtered row bytes worth a thread of its own
+constexpr size_t kSSPNGMinBandBytes = 4 << 20;
+
+/// Largest band of filtered row bytes, which bounds both the memory each band's compressed
+/// output takes and the size of its IDAT chunk
+constexpr size_t kSSPNGMaxBandBytes = 32 << 20;
+
+/// Append bitmap, encoded as a PNG, to out. Returns false for an empty bitmap. threadCount
+/// caps the number of bands deflated at once; 0 uses every hardware thread.
+bool SSPNG_writeToMemory(
+    const GBitmap& bitmap,
+    std::vector<uint8_t>& out,
+    SSCompression compression = SSCompression::kFast,
+    int threadCount = 0
+);
+
+/// Encode bitmap and write it to a new file at path (created or overwritten).
+bool SSPNG_writeToFile(
+    const GBitmap& bitmap,
+    const char path[],
+    SSCompression compression = SSCompression::kFast,
+    int threadCount = 0
+);
+
+/// Update a CRC-32 (start from 0) with size more bytes.
+uint32_t SSCRC32(uint32_t crc, const uint8_t data[], size_t size);
+
+#endif // SSPNG_DEFINED
@@ -0,0 +1,124 @@
+#ifndef SSPipeline_DEFINED
+#define SSPipeline_DEFINED
+
+#include "include/GShader.h"
+#include "include/GPixel.h"
+#include "SSBlendModeHelpers.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+/// Number of pixels every stage works on at a time. 16 GPixels are 64 bytes: one cache line,
+/// one AVX-512 register or two AVX2 registers, so a chunk never leaves L1 between stages.
+constexpr int kSSPipelineChunk = 16;
+
+/// The working set that flows through the stages of a pipeline, one chunk at a time.
+struct SSPipelineRegisters {
+    /// Device coordinates of the first pixel in the chunk, and the chunk's width (<= kSSPipelineChunk)
+    int x;
+    int y;
+    int count;
+
+    /// Premultiplied pixels produced by the most recent sample stage
+    GPixel src[kSSPipelineChunk];
+
+    /// Side register, used to hold one stage's output while another sample stage runs
+    GPixel aux[kSSPipelineChunk];
+};
+
+/// A stage reads and/or writes the registers. Context is whatever the stage was appended with.
+typedef void (*SSPipelineStageFunction)(SSPipelineRegisters& registers, void* context);
+
+struct SSPipelineStage {
+    SSPipelineStageFunction function;
+    void* context;
+};
+
+/// A flat list of stages, compiled once (when a shader is built) and then run over each span
+/// in register-sized chunks, so that nested shaders cost one loop instead of one pass each.
+class SSPipeline {
+public:
+    static constexpr int kMaxStages = 16;
+
+    /// Append a stage to the end of the pipeline. If it already holds kMaxStages, the stage is
+    /// dropped, the pipeline is marked as overflowed and this returns false.
+    bool append(SSPipelineStageFunction function, void* context = nullptr) {
+        if (stageCount == kMaxStages) {
+            overflowed = true;
+            return false;
+        }
+
+        stages[stageCount] = { function, context };
+        stageCount += 1;
+        return true;
+    }
+
+    /// Remove all stages.
+    void reset() {
+        truncate(0);
+    }
+
+    /// Keep only the first count stages, and clear the overflow, so a caller whose stages didn't
+    /// fit can replace them with fewer.
+    void truncate(int count) {
+        assert(count >= 0 && count <= stageCount);
+        stageCount = count;
+        overflowed = false;
+    }
+
+    int count() const {
+        return stageCount;
+    }
+
+    /// Whether an append has been dropped since the last reset or truncate. An overflowed
+    /// pipeline is missing stages and must not be run.
+    bool hasOverflowed() const {
+        return overflowed;
+    }
+
+    /// Run every stage over [x, y] ... [x + count - 1, y], writing the final src register into
+    /// row[0...count - 1].
+    void run(int x, int y, int count, GPixel row[]) const {
+        assert(!overflowed);
+        SSPipelineRegisters registers;
+        registers.y = y;
+
+        for (int i = 0; i < count; i += kSSPipelineChunk) {
+            registers.x = x + i;
+            registers.count = std::min(kSSPipelineChunk, count - i);
+
+            for (int s = 0; s < stageCount; s++) {
+                stages[s].function(registers, stages[s].context);
+            }
+
+            memcpy(&row[i], registers.src, registers.count * sizeof(GPixel));
+        }
+    }
+
+private:
+    SSPipelineStage stages[kMaxStages];
+    int stageCount = 0;
+    bool overflowed = false;
+};
+
+// MARK: Common Stages
+
+/// Sample stage for any GShader that can't contribute stages of its own: one virtual shadeRow
+/// per chunk, straight into the src register.
+static inline void SSPipelineStage_shadeRow(SSPipelineRegisters& registers, void* context) {
+    static_cast<GShader*>(context)->shadeRow(registers.x, registers.y, registers.count, registers.src);
+}
+
+/// Copy src into aux, freeing src for the next sample stage.
+static inline void SSPipelineStage_saveToAux(SSPipelineRegisters& registers, void* context) {
+    memcpy(registers.aux, registers.src, registers.count * sizeof(GPixel));
+}
+
+/// src = src * aux, component by component.
+static inline void SSPipelineStage_modulate(SSPipelineRegisters& registers, void* context) {
+    for (int i = 0; i < registers.count; i++) {
+        registers.src[i] = blendModulate(registers.src[i], &registers.aux[i]);
+    }
+}
+
+#endif // SSPipeline_DEFINED
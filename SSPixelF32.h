@@ -0,0 +1,122 @@
+#ifndef SSPixelF32_DEFINED
+#define SSPixelF32_DEFINED
+
+#include "include/GColor.h"
+#include "include/GPixel.h"
+#include "SSVector.h"
+
+/// A premultiplied pixel in floats, { r, g, b, a } with each component in [0, 1]. This is what
+/// SSCanvas keeps per pixel in SSPrecision::kF32 mode, so that blending never rounds.
+typedef SSFloat32x4 SSPixelF32;
+
+// MARK: Conversions
+
+static inline SSPixelF32 SSPixelF32_alpha(SSPixelF32 pixel) {
+    return SSFloat32x4_splat(pixel[3]);
+}
+
+static inline SSPixelF32 SSPixelF32_fromPixel(GPixel pixel) {
+    const SSPixelF32 components = {
+        (float) GPixel_GetR(pixel),
+        (float) GPixel_GetG(pixel),
+        (float) GPixel_GetB(pixel),
+        (float) GPixel_GetA(pixel)
+    };
+
+    return components * (1.0f / 255);
+}
+
+/// Premultiply color, without rounding it to 8 bits
+static inline SSPixelF32 SSPixelF32_fromColor(const GColor& color) {
+    return SSPixelF32{ color.r * color.a, color.g * color.a, color.b * color.a, color.a };
+}
+
+static_assert(GPIXEL_SHIFT_A == 24 && GPIXEL_SHIFT_R == 16 && GPIXEL_SHIFT_G == 8 && GPIXEL_SHIFT_B == 0,
+              "SSPixelF32_toPixel packs bytes in ARGB order");
+
+/// Round to the nearest GPixel. Components are pinned to [0, 1] and colors to alpha first, so
+/// float error can never produce an invalid premultiplied pixel.
+///
+/// This runs once per pixel per kF32 fill, so it stays in vector registers: alpha is pinned
+/// lane-wise, and the low byte of each lane is gathered with one byte shuffle into b, g, r, a
+/// order, rather than extracted and shifted into place one component at a time.
+static inline GPixel SSPixelF32_toPixel(SSPixelF32 pixel) {
+    const SSPixelF32 alpha = SSFloat32x4_min(SSFloat32x4_max(SSPixelF32_alpha(pixel), SSFloat32x4_splat(0)), SSFloat32x4_splat(1));
+    const SSPixelF32 pinned = SSFloat32x4_min(SSFloat32x4_max(pixel, SSFloat32x4_splat(0)), alpha);
+    const SSUInt8x16 bytes = (SSUInt8x16) __builtin_convertvector(pinned * 255.0f + 0.5f, SSInt32x4);
+
+#if defined(__clang__)
+    const SSUInt8x16 packed = __builtin_shufflevector(bytes, bytes, 8, 4, 0, 12, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+#else
+    const SSUInt8x16 packed = __builtin_shuffle(bytes, SSUInt8x16{ 8, 4, 0, 12 });
+#endif
+
+    return ((SSUInt32x4) packed)[0];
+}
+
+// MARK: Blend Modes
+
+/// The twelve Porter-Duff modes of SSBlendModeHelpers.h, on premultiplied floats. Without
+/// integer division there's nothing to round, so each is its textbook formula.
+
+static inline auto blendF32Clear = [](SSPixelF32 src, SSPixelF32 dst) {
+    // 0
+    return SSFloat32x4_splat(0);
+};
+
+static inline auto blendF32Src = [](SSPixelF32 src, SSPixelF32 dst) {
+    // S
+    return src;
+};
+
+static inline auto blendF32Dst = [](SSPixelF32 src, SSPixelF32 dst) {
+    // D
+    return dst;
+};
+
+static inline auto blendF32SrcOver = [](SSPixelF32 src, SSPixelF32 dst) {
+    // S + (1 - Sa) * D
+    return src + (1 - SSPixelF32_alpha(src)) * dst;
+};
+
+static inline auto blendF32DstOver = [](SSPixelF32 src, SSPixelF32 dst) {
+    // D + (1 - Da) * S
+    return dst + (1 - SSPixelF32_alpha(dst)) * src;
+};
+
+static inline auto blendF32SrcIn = [](SSPixelF32 src, SSPixelF32 dst) {
+    // Da * S
+    return SSPixelF32_alpha(dst) * src;
+};
+
+static inline auto blendF32DstIn = [](SSPixelF32 src, SSPixelF32 dst) {
+    // Sa * D
+    return SSPixelF32_alpha(src) * dst;
+};
+
+static inline auto blendF32SrcOut = [](SSPixelF32 src, SSPixelF32 dst) {
+    // (1 - Da) * S
+    return (1 - SSPixelF32_alpha(dst)) * src;
+};
+
+static inline auto blendF32DstOut = [](SSPixelF32 src, SSPixelF32 dst) {
+    // (1 - Sa) * D
+    return (1 - SSPixelF32_alpha(src)) * dst;
+};
+
+static inline auto blendF32SrcATop = [](SSPixelF32 src, SSPixelF32 dst) {
+    // Da * S + (1 - Sa) * D
+    return SSPixelF32_alpha(dst) * src + (1 - SSPixelF32_alpha(src)) * dst;
+};
+
+static inline auto blendF32DstATop = [](SSPixelF32 src, SSPixelF32 dst) {
+    // Sa * D + (1 - Da) * S
+    return SSPixelF32_alpha(src) * dst + (1 - SSPixelF32_alpha(dst)) * src;
+};
+
+static inline auto blendF32Xor = [](SSPixelF32 src, SSPixelF32 dst) {
+    // (1 - Sa) * D + (1 - Da) * S
+    return (1 - SSPixelF32_alpha(src)) * dst + (1 - SSPixelF32_alpha(dst)) * src;
+};
+
+#endif // SSPixelF32_DEFINED
@@ -0,0 +1,80 @@
+#include "SSPixelPool.h"
+#include <cstdlib>
+
+/// size rounded up to a multiple of an eighth of the power of two above it: four classes per
+/// doubling, so at most 25% waste. Always a multiple of alignment.
+static size_t sizeClass(size_t size, size_t alignment) {
+    size_t step = alignment;
+    while (step * 8 <= size) step *= 2;
+
+    return (size + step - 1) / step * step;
+}
+
+SSPixelPool::~SSPixelPool() {
+    purge();
+}
+
+std::shared_ptr<void> SSPixelPool::acquire(size_t size, size_t alignment, bool* recycled) {
+    const size_t blockSize = sizeClass(size, alignment);
+    void* block = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto bucket = buckets.find({ blockSize, alignment });
+
+        if (bucket != buckets.end() && !bucket->second.empty()) {
+            block = bucket->second.back();
+            bucket->second.pop_back();
+            pooled -= blockSize;
+        }
+    }
+
+    if (recycled) *recycled = block != nullptr;
+
+    if (!block) {
+        block = aligned_alloc(alignment, blockSize);
+        if (!block) return nullptr;
+    }
+
+    return std::shared_ptr<void>(block, [this, blockSize, alignment](void* block) {
+        release(block, blockSize, alignment);
+    });
+}
+
+void SSPixelPool::release(void* block, size_t size, size_t alignment) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (pooled + size <= capacity) {
+            buckets[{ size, alignment }].push_back(block);
+            pooled += size;
+            return;
+        }
+    }
+
+    free(block);
+}
+
+void SSPixelPool::purge() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& bucket : buckets) {
+        for (void* block : bucket.second) {
+            free(block);
+        }
+    }
+
+    buckets.clear();
+    pooled = 0;
+}
+
+size_t SSPixelPool::pooledBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pooled;
+}
+
+SSPixelPool& SSPixelPool::Shared() {
+    // Never destroyed, so bitmaps released during exit still have somewhere to go
+    static SSPixelPool* shared = new SSPixelPool();
+    return *shared;
+}
@@ -0,0 +1,58 @@
+#ifndef SSPixelPool_DEFINED
+#define SSPixelPool_DEFINED
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/// Blocks a pool holds on to for reuse, at most, by default
+constexpr size_t kSSPixelPoolDefaultCapacity = 256 << 20;
+
+/// Recycles pixel memory between bitmaps. Blocks are handed out as GBitmap storage (see
+/// GBitmap::storage) and come back to the pool, rather than to free(), when the last bitmap
+/// using one lets go. Rendering frame after frame of the same size then reuses the same pages:
+/// no page faults, and no zeroing unless asked for.
+///
+/// Blocks are bucketed by size class, four to each doubling, so bitmaps of nearly the same size
+/// share blocks too.
+///
+/// The pool must outlive every block it hands out. Shared() never goes away.
+class SSPixelPool {
+public:
+    explicit SSPixelPool(size_t capacity = kSSPixelPoolDefaultCapacity) : capacity(capacity) {}
+    ~SSPixelPool();
+
+    SSPixelPool(const SSPixelPool&) = delete;
+    SSPixelPool& operator=(const SSPixelPool&) = delete;
+
+    /// A block of at least size bytes aligned to alignment (a power of two). recycled, if
+    /// given, is set to whether it was used before, in which case it holds whatever its last
+    /// user left. Returns null if the memory can't be allocated.
+    std::shared_ptr<void> acquire(size_t size, size_t alignment, bool* recycled = nullptr);
+
+    /// Free every block waiting to be reused
+    void purge();
+
+    /// Bytes in blocks waiting to be reused
+    size_t pooledBytes() const;
+
+    /// The pool the image app and other one-per-process renderers share
+    static SSPixelPool& Shared();
+
+private:
+    /// Keep block for reuse, or free it if the pool is full
+    void release(void* block, size_t size, size_t alignment);
+
+    const size_t capacity;
+
+    mutable std::mutex mutex;
+    size_t pooled = 0;
+
+    /// Free blocks by (size class, alignment)
+    std::map<std::pair<size_t, size_t>, std::vector<void*>> buckets;
+};
+
+#endif // SSPixelPool_DEFINED
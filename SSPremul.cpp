@@ -0,0 +1,104 @@
+#include "SSPremul.h"
+#include "SSVector.h"
+#include <cstring>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "RGBA bytes are read as little endian words");
+
+/// Byte i of each lane, as its own lane
+static inline SSUInt32x4 byteLanes(SSUInt32x4 words, int i) {
+    return (words >> (8 * i)) & 0xFF;
+}
+
+static inline uint32_t premultiply(uint32_t a, uint32_t c) {
+    return ((a * c + 128) * 257) >> 16;
+}
+
+static inline uint32_t unpremultiply(uint32_t a, uint32_t c) {
+    return (c * kSSPremulTables.unpremulScale[a] + 0x8000) >> 16;
+}
+
+/// Premultiply count pixels of RGBA bytes into dst.
+SS_TARGET_CLONES
+void SSPremul_premultiplyRow(GPixel dst[], const uint8_t src[], int count) {
+    int i = 0;
+
+    for (; i + kSSVectorLanes <= count; i += kSSVectorLanes) {
+        // Bytes R, G, B, A are one little endian word per pixel
+        SSUInt32x4 words;
+        memcpy(&words, src + 4 * i, sizeof(words));
+
+        const SSUInt32x4 a = byteLanes(words, 3);
+        const SSUInt32x4 r = ((a * byteLanes(words, 0) + 128) * 257) >> 16;
+        const SSUInt32x4 g = ((a * byteLanes(words, 1) + 128) * 257) >> 16;
+        const SSUInt32x4 b = ((a * byteLanes(words, 2) + 128) * 257) >> 16;
+
+        const SSUInt32x4 pixels =
+            (a << GPIXEL_SHIFT_A) | (r << GPIXEL_SHIFT_R) | (g << GPIXEL_SHIFT_G) | (b << GPIXEL_SHIFT_B);
+        memcpy(dst + i, &pixels, sizeof(pixels));
+    }
+
+    for (; i < count; i++) {
+        const uint8_t* rgba = src + 4 * i;
+        const uint32_t a = rgba[3];
+        dst[i] = GPixel_PackARGB(a, premultiply(a, rgba[0]), premultiply(a, rgba[1]), premultiply(a, rgba[2]));
+    }
+}
+
+/// Unpremultiply count pixels into RGBA bytes.
+SS_TARGET_CLONES
+void SSPremul_unpremultiplyRow(uint8_t dst[], const GPixel src[], int count) {
+    int i = 0;
+
+    for (; i + kSSVectorLanes <= count; i += kSSVectorLanes) {
+        SSUInt32x4 pixels;
+        memcpy(&pixels, src + i, sizeof(pixels));
+
+        const SSUInt32x4 a = (pixels >> GPIXEL_SHIFT_A) & 0xFF;
+        const SSUInt32x4 scale = {
+            kSSPremulTables.unpremulScale[a[0]],
+            kSSPremulTables.unpremulScale[a[1]],
+            kSSPremulTables.unpremulScale[a[2]],
+            kSSPremulTables.unpremulScale[a[3]]
+        };
+
+        const SSUInt32x4 r = (((pixels >> GPIXEL_SHIFT_R) & 0xFF) * scale + 0x8000) >> 16;
+        const SSUInt32x4 g = (((pixels >> GPIXEL_SHIFT_G) & 0xFF) * scale + 0x8000) >> 16;
+        const SSUInt32x4 b = (((pixels >> GPIXEL_SHIFT_B) & 0xFF) * scale + 0x8000) >> 16;
+
+        const SSUInt32x4 words = r | (g << 8) | (b << 16) | (a << 24);
+        memcpy(dst + 4 * i, &words, sizeof(words));
+    }
+
+    for (; i < count; i++) {
+        const GPixel pixel = src[i];
+        const uint32_t a = GPixel_GetA(pixel);
+        uint8_t* rgba = dst + 4 * i;
+
+        rgba[0] = unpremultiply(a, GPixel_GetR(pixel));
+        rgba[1] = unpremultiply(a, GPixel_GetG(pixel));
+        rgba[2] = unpremultiply(a, GPixel_GetB(pixel));
+        rgba[3] = a;
+    }
+}
+
+/// Whether all count pixels have 0xFF alpha.
+SS_TARGET_CLONES
+bool SSPremul_isOpaqueRow(const GPixel row[], int count) {
+    constexpr int kBlock = 4 * kSSVectorLanes;
+    int i = 0;
+
+    for (; i + kBlock <= count; i += kBlock) {
+        SSUInt32x4 pixels[4];
+        memcpy(pixels, row + i, sizeof(pixels));
+
+        // Alpha survives the AND as 0xFF only if it was 0xFF in every pixel
+        const SSUInt32x4 all = pixels[0] & pixels[1] & pixels[2] & pixels[3];
+        if (GPixel_GetA(all[0] & all[1] & all[2] & all[3]) != 0xFF) return false;
+    }
+
+    for (; i < count; i++) {
+        if (GPixel_GetA(row[i]) != 0xFF) return false;
+    }
+
+    return true;
+}
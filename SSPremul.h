@@ -0,0 +1,45 @@
+#ifndef SSPremul_DEFINED
+#define SSPremul_DEFINED
+
+#include <cstdint>
+#include "include/GPixel.h"
+
+/// Row converters between premultiplied GPixels and unpremultiplied RGBA bytes (PNG's layout),
+/// four pixels per iteration and without a single division:
+///
+///     premultiply:   (a * c + 127) / 255       ==  ((a * c + 128) * 257) >> 16
+///     unpremultiply: (c * 255 + a / 2) / a     ==  (c * unpremulScale[a] + 0x8000) >> 16
+///
+/// with unpremulScale[a] = ceil((255 << 16) / a). Both identities were checked exhaustively, for
+/// every alpha and every component that is valid under it, so the results match the division
+/// formulas bit for bit.
+struct SSPremulTables {
+    /// ceil((255 << 16) / a), and 0 for a == 0
+    uint32_t unpremulScale[256] = {};
+
+    /// 1 / a, and 0 for a == 0: multiplying a premultiplied component by it unpremultiplies it
+    /// straight to [0, 1]
+    float unpremulReciprocal[256] = {};
+
+    constexpr SSPremulTables() {
+        for (uint32_t a = 1; a < 256; a++) {
+            unpremulScale[a] = ((255u << 16) + a - 1) / a;
+            unpremulReciprocal[a] = 1.0f / static_cast<float>(a);
+        }
+    }
+};
+
+/// Built at compile time, so the tables cost no startup work
+inline constexpr SSPremulTables kSSPremulTables;
+
+/// Premultiply count pixels of RGBA bytes into dst.
+void SSPremul_premultiplyRow(GPixel dst[], const uint8_t src[], int count);
+
+/// Unpremultiply count pixels into RGBA bytes. Transparent pixels come out as 0, 0, 0, 0.
+void SSPremul_unpremultiplyRow(uint8_t dst[], const GPixel src[], int count);
+
+/// Whether all count pixels have 0xFF alpha. Sixteen pixels are ANDed together per check, so
+/// opaque rows cost one branch per sixteen pixels, and a translucent one returns within sixteen.
+bool SSPremul_isOpaqueRow(const GPixel row[], int count);
+
+#endif // SSPremul_DEFINED
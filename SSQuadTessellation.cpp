@@ -0,0 +1,64 @@
+#include "SSQuadTessellation.h"
+#include <mutex>
+#include <vector>
+
+static int quadIndexCount(int level) {
+    return (level + 1) * (level + 1) * 6;
+}
+
+/// Write level's quadIndexCount(level) indices to indices[]
+static void fillQuadIndices(int level, int indices[]) {
+    const int samplesPerSide = level + 2;
+    const int subQuadsPerSide = level + 1;
+    int* next = indices;
+
+    for (int row = 0; row < subQuadsPerSide; row++) {
+        for (int col = 0; col < subQuadsPerSide; col++) {
+            // TL   TR
+            // *-----*
+            // |    /|
+            // |   / |
+            // |  /  |
+            // | /   |
+            // |/    |
+            // *-----*
+            // BL   BR
+            int topLeft     = (row * samplesPerSide) + col;
+            int topRight    = topLeft + 1;
+            int bottomLeft  = topLeft + samplesPerSide;
+            int bottomRight = bottomLeft + 1;
+
+            // Build top left triangle in sub-quad
+            *next++ = topLeft;
+            *next++ = topRight;
+            *next++ = bottomLeft;
+
+            // Build bottom right triangle in sub-quad
+            *next++ = topRight;
+            *next++ = bottomRight;
+            *next++ = bottomLeft;
+        }
+    }
+}
+
+const int* SSQuadIndices(int level, SSArena& arena) {
+    assert(level >= 0);
+
+    if (level > kSSQuadMaxCachedLevel) {
+        int* indices = arena.allocate<int>(quadIndexCount(level));
+        fillQuadIndices(level, indices);
+        return indices;
+    }
+
+    // Index buffers only depend on level, so each one is built once, by whichever thread asks
+    // for it first, and then shared
+    static std::once_flag built[kSSQuadMaxCachedLevel + 1];
+    static std::vector<int> cache[kSSQuadMaxCachedLevel + 1];
+
+    std::call_once(built[level], [level]() {
+        cache[level].resize(quadIndexCount(level));
+        fillQuadIndices(level, cache[level].data());
+    });
+
+    return cache[level].data();
+}
@@ -0,0 +1,49 @@
+#ifndef SSQuadTessellation_DEFINED
+#define SSQuadTessellation_DEFINED
+
+#include "include/GPoint.h"
+#include "include/GColor.h"
+#include "SSArena.h"
+
+/// Highest level whose index buffer SSQuadIndices keeps for the life of the process
+constexpr int kSSQuadMaxCachedLevel = 64;
+
+/// Index buffer for a quad tessellated at level (see SSCanvas::drawQuad): (level + 1)^2
+/// sub-quads, each split on its top-right --> bottom-left diagonal into the clockwise triangles
+///     top-left --> top-right --> bottom-left
+///     top-right --> bottom-right --> bottom-left
+/// over a row-major grid of (level + 2)^2 samples. level must be >= 0.
+///
+/// Buffers up to kSSQuadMaxCachedLevel are built on first use and shared, safely across threads;
+/// higher levels are built into arena for the caller's scope.
+const int* SSQuadIndices(int level, SSArena& arena);
+
+/// Fill out[] with a row-major samplesPerSide x samplesPerSide grid, bilinearly interpolated
+/// between corners (ordered top-left --> top-right --> bottom-right --> bottom-left).
+///
+/// Each row's end points are interpolated directly and the samples between them by forward
+/// differencing, so the rows and columns along the sides only depend on the corners they join,
+/// and quads that share a side and a level share those samples exactly.
+template <typename T>
+void SSFillBilinearGrid(const T corners[4], int samplesPerSide, T out[]) {
+    const float steps = samplesPerSide - 1;
+
+    for (int row = 0; row < samplesPerSide; row++) {
+        float v = row / steps;
+        T left = corners[0] + v * (corners[3] - corners[0]);
+        T right = corners[1] + v * (corners[2] - corners[1]);
+        T step = (1 / steps) * (right - left);
+
+        T* rowSamples = &out[row * samplesPerSide];
+        T sample = left;
+
+        for (int col = 0; col < samplesPerSide - 1; col++) {
+            rowSamples[col] = sample;
+            sample += step;
+        }
+
+        rowSamples[samplesPerSide - 1] = right;
+    }
+}
+
+#endif // SSQuadTessellation_DEFINED
@@ -0,0 +1,42 @@
+#ifndef SSShader_DEFINED
+#define SSShader_DEFINED
+
+#include "include/GShader.h"
+#include "SSPipeline.h"
+
+/// Base class for shaders that can contribute their work as pipeline stages, so that shaders
+/// which wrap other shaders (modulating, color matrix, triangle texture) can fuse the whole
+/// chain into a single SSPipeline instead of proxying through nested shadeRow calls.
+class SSShader : public GShader {
+public:
+    /// Append the stages that leave this shader's premultiplied output in the src register.
+    /// By default this is a single stage that calls through to shadeRow.
+    virtual void appendStages(SSPipeline& pipeline) {
+        pipeline.append(SSPipelineStage_shadeRow, this);
+    }
+
+    /// Like setContext(), but given the CTM already inverted (device -> shader space), for
+    /// callers that have the inverse on hand. By default it is inverted back for setContext().
+    virtual bool setInverseContext(const GMatrix& inverseCTM) {
+        auto ctm = inverseCTM.invert();
+        return ctm && setContext(ctm.value());
+    }
+};
+
+/// Append the stages for any shader, falling back to a shadeRow stage if it isn't an SSShader
+/// or its stages don't fit in what is left of the pipeline.
+static inline void SSShader_appendStages(SSPipeline& pipeline, GShader* shader) {
+    SSShader* ssShader = dynamic_cast<SSShader*>(shader);
+
+    if (ssShader && !pipeline.hasOverflowed()) {
+        const int start = pipeline.count();
+        ssShader->appendStages(pipeline);
+
+        if (!pipeline.hasOverflowed()) return;
+        pipeline.truncate(start);
+    }
+
+    pipeline.append(SSPipelineStage_shadeRow, shader);
+}
+
+#endif // SSShader_DEFINED
@@ -0,0 +1,40 @@
+#ifndef SSSpan_DEFINED
+#define SSSpan_DEFINED
+
+#include "SSArena.h"
+
+#include <algorithm>
+
+/// A run of pixels [left, right) on row y
+struct SSSpan {
+    int y;
+    int left;
+    int right;
+};
+
+/// Sort spans by row and then left edge, and merge the ones that overlap or touch, so that
+/// every pixel is covered by at most one span.
+static inline void SSSpan_sortAndMerge(SSArenaArray<SSSpan>& spans) {
+    if (spans.empty()) return;
+
+    std::sort(spans.begin(), spans.end(), [](const SSSpan& lhs, const SSSpan& rhs) {
+        return lhs.y < rhs.y || (lhs.y == rhs.y && lhs.left < rhs.left);
+    });
+
+    size_t merged = 0;
+
+    for (size_t i = 1; i < spans.size(); i++) {
+        SSSpan& last = spans[merged];
+
+        if (spans[i].y == last.y && spans[i].left <= last.right) {
+            last.right = std::max(last.right, spans[i].right);
+        } else {
+            merged += 1;
+            spans[merged] = spans[i];
+        }
+    }
+
+    spans.truncate(merged + 1);
+}
+
+#endif // SSSpan_DEFINED
@@ -0,0 +1,230 @@
+#include "SSSpanBlitter.h"
+#include "SSTrace.h"
+
+/// Record a batch that began at start as a "shade" zone of shadeTime and then a "blend" zone for
+/// the rest. Shading and blending alternate span by span, so each is summed over the batch and
+/// the two are laid end to end.
+static void traceBatch(GNSec start, GNSec shadeTime) {
+    const GNSec end = GTime::GetNSec();
+
+    if (shadeTime > 0) SSTrace_addEvent("shade", start, shadeTime);
+    SSTrace_addEvent("blend", start + shadeTime, end - start - shadeTime);
+}
+
+template <typename BlendFunction>
+void SSSpanBlitter::blitBatch(BlendFunction blend) {
+    const bool traced = SSTrace_isEnabled();
+    const GNSec batchStart = traced ? GTime::GetNSec() : 0;
+    GNSec shadeTime = 0;
+
+    if (shader) {
+        for (int i = 0; i < count; i++) {
+            const SSSpan& span = spans[i];
+            const int width = span.right - span.left;
+
+            const GNSec shadeStart = traced ? GTime::GetNSec() : 0;
+            shader->shadeRow(span.left, span.y, width, src);
+            if (traced) shadeTime += GTime::GetNSec() - shadeStart;
+
+            GPixel *row = bitmap.getAddr(span.left, span.y);
+
+            for (int x = 0; x < width; x++) {
+                row[x] = blend(src[x], &row[x]);
+            }
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            const SSSpan& span = spans[i];
+            const int width = span.right - span.left;
+
+            GPixel *row = bitmap.getAddr(span.left, span.y);
+
+            for (int x = 0; x < width; x++) {
+                row[x] = blend(color, &row[x]);
+            }
+        }
+    }
+
+    if (traced) traceBatch(batchStart, shadeTime);
+}
+
+/// Blend one span in floats: dst[x] = blend(src[x], dst[x]), with src the shader's row or, if
+/// it is null, color. Each result is also rounded into out[x].
+template <typename BlendFunction>
+SS_TARGET_CLONES
+static void blendRowF32(
+    SSPixelF32* dst,
+    GPixel* out,
+    const GPixel* src,
+    SSPixelF32 color,
+    int width,
+    BlendFunction blend
+) {
+    for (int x = 0; x < width; x++) {
+        const SSPixelF32 source = src ? SSPixelF32_fromPixel(src[x]) : color;
+        dst[x] = blend(source, dst[x]);
+        out[x] = SSPixelF32_toPixel(dst[x]);
+    }
+}
+
+template <typename BlendFunction>
+void SSSpanBlitter::blitBatchF32(BlendFunction blend) {
+    const int stride = bitmap.width();
+    const bool traced = SSTrace_isEnabled();
+    const GNSec batchStart = traced ? GTime::GetNSec() : 0;
+    GNSec shadeTime = 0;
+
+    // Without a shader kClear and kSrc store the same value everywhere, so round it once
+    if (!shader && (blendMode == GBlendMode::kClear || blendMode == GBlendMode::kSrc)) {
+        const SSPixelF32 value = blend(colorF32, SSFloat32x4_splat(0));
+        const GPixel pixel = SSPixelF32_toPixel(value);
+
+        for (int i = 0; i < count; i++) {
+            const SSSpan& span = spans[i];
+            const int width = span.right - span.left;
+            SSPixelF32* dst = f32Pixels + span.y * stride + span.left;
+            GPixel* row = bitmap.getAddr(span.left, span.y);
+
+            std::fill(dst, dst + width, value);
+            std::fill(row, row + width, pixel);
+        }
+
+        if (traced) traceBatch(batchStart, shadeTime);
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const SSSpan& span = spans[i];
+        const int width = span.right - span.left;
+
+        if (shader) {
+            const GNSec shadeStart = traced ? GTime::GetNSec() : 0;
+            shader->shadeRow(span.left, span.y, width, src);
+            if (traced) shadeTime += GTime::GetNSec() - shadeStart;
+        }
+
+        SSPixelF32* dst = f32Pixels + span.y * stride + span.left;
+        blendRowF32(dst, bitmap.getAddr(span.left, span.y), shader ? src : nullptr, colorF32, width, blend);
+    }
+
+    if (traced) traceBatch(batchStart, shadeTime);
+}
+
+/// Shade and blend every queued span.
+void SSSpanBlitter::flush() {
+    if (count == 0) return;
+
+    if (f32Pixels) {
+        flushF32();
+        return;
+    }
+
+    switch (blendMode) {
+    case GBlendMode::kClear: {
+        blitBatch(blendClear);
+        break;
+    }
+    case GBlendMode::kSrc: {
+        blitBatch(blendSrc);
+        break;
+    }
+    case GBlendMode::kDst: {
+        // Nothing to draw
+        break;
+    }
+    case GBlendMode::kSrcOver: {
+        blitBatch(blendSrcOver);
+        break;
+    }
+    case GBlendMode::kDstOver: {
+        blitBatch(blendDstOver);
+        break;
+    }
+    case GBlendMode::kSrcIn: {
+        blitBatch(blendSrcIn);
+        break;
+    }
+    case GBlendMode::kDstIn: {
+        blitBatch(blendDstIn);
+        break;
+    }
+    case GBlendMode::kSrcOut: {
+        blitBatch(blendSrcOut);
+        break;
+    }
+    case GBlendMode::kDstOut: {
+        blitBatch(blendDstOut);
+        break;
+    }
+    case GBlendMode::kSrcATop: {
+        blitBatch(blendSrcATop);
+        break;
+    }
+    case GBlendMode::kDstATop: {
+        blitBatch(blendDstATop);
+        break;
+    }
+    case GBlendMode::kXor: {
+        blitBatch(blendXor);
+        break;
+    }
+    }
+
+    count = 0;
+}
+
+/// Like flush, blending into f32Pixels.
+void SSSpanBlitter::flushF32() {
+    switch (blendMode) {
+    case GBlendMode::kClear: {
+        blitBatchF32(blendF32Clear);
+        break;
+    }
+    case GBlendMode::kSrc: {
+        blitBatchF32(blendF32Src);
+        break;
+    }
+    case GBlendMode::kDst: {
+        // Nothing to draw
+        break;
+    }
+    case GBlendMode::kSrcOver: {
+        blitBatchF32(blendF32SrcOver);
+        break;
+    }
+    case GBlendMode::kDstOver: {
+        blitBatchF32(blendF32DstOver);
+        break;
+    }
+    case GBlendMode::kSrcIn: {
+        blitBatchF32(blendF32SrcIn);
+        break;
+    }
+    case GBlendMode::kDstIn: {
+        blitBatchF32(blendF32DstIn);
+        break;
+    }
+    case GBlendMode::kSrcOut: {
+        blitBatchF32(blendF32SrcOut);
+        break;
+    }
+    case GBlendMode::kDstOut: {
+        blitBatchF32(blendF32DstOut);
+        break;
+    }
+    case GBlendMode::kSrcATop: {
+        blitBatchF32(blendF32SrcATop);
+        break;
+    }
+    case GBlendMode::kDstATop: {
+        blitBatchF32(blendF32DstATop);
+        break;
+    }
+    case GBlendMode::kXor: {
+        blitBatchF32(blendF32Xor);
+        break;
+    }
+    }
+
+    count = 0;
+}
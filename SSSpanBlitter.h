@@ -0,0 +1,90 @@
+#ifndef SSSpanBlitter_DEFINED
+#define SSSpanBlitter_DEFINED
+
+#include "include/GBitmap.h"
+#include "include/GBlendMode.h"
+#include "include/GShader.h"
+#include "SSArena.h"
+#include "SSBlendModeHelpers.h"
+#include "SSPixelF32.h"
+#include "SSSpan.h"
+#include "SSStats.h"
+
+/// The second half of every fill: rasterizers hand their spans to addSpan(), which only queues
+/// them, and once kBatchSize spans are waiting (or on flush()) the whole batch is shaded and
+/// blended in one go. Edge walking and shading each run in their own tight loop with their own
+/// data in cache, and the blend mode is switched on once per batch rather than once per draw
+/// call's code path.
+///
+/// Spans must stay inside the bitmap. The shader, if any, must already have its context set, and
+/// be flushed before it is changed (drawMesh flushes between triangles).
+class SSSpanBlitter {
+public:
+    /// Spans queued before a batch is shaded and blended
+    static constexpr int kBatchSize = 256;
+
+    /// blendMode should already be simplified; kDst draws nothing. Without a shader every span
+    /// is filled with color. Scratch memory comes from arena, so the blitter must not outlive
+    /// the SSArenaScope it was made in.
+    ///
+    /// With f32Pixels (one per bitmap pixel, row after row) the blitter blends in floats into
+    /// them instead, and only writes the rounded result to the bitmap.
+    SSSpanBlitter(
+        const GBitmap& bitmap,
+        SSArena& arena,
+        GBlendMode blendMode,
+        GShader* shader,
+        const GColor& color,
+        SSPixelF32* f32Pixels = nullptr
+    )
+        : bitmap(bitmap)
+        , blendMode(blendMode)
+        , shader(shader)
+        , color(colorToPixel(color))
+        , colorF32(SSPixelF32_fromColor(color))
+        , f32Pixels(f32Pixels)
+        , spans(arena.allocate<SSSpan>(kBatchSize))
+        , src(shader ? arena.allocate<GPixel>(bitmap.width()) : nullptr)
+    {}
+
+    void addSpan(int left, int right, int y) {
+        if (left >= right) return;
+
+        SS_STAT_ADD(spans, 1);
+        SS_STAT_ADD(pixelsShaded, shader ? right - left : 0);
+        SS_STAT_ADD(pixelsBlended[static_cast<int>(blendMode)], right - left);
+
+        spans[count++] = { y, left, right };
+        if (count == kBatchSize) flush();
+    }
+
+    /// Shade and blend every queued span.
+    void flush();
+
+private:
+    /// flush() for a float destination
+    void flushF32();
+
+    template <typename BlendFunction>
+    void blitBatch(BlendFunction blend);
+
+    template <typename BlendFunction>
+    void blitBatchF32(BlendFunction blend);
+
+    const GBitmap& bitmap;
+    const GBlendMode blendMode;
+    GShader* const shader;
+    const GPixel color;
+    const SSPixelF32 colorF32;
+
+    /// Float destination, or null to blend the bitmap's own pixels
+    SSPixelF32* const f32Pixels;
+
+    SSSpan* const spans;
+    int count = 0;
+
+    /// One row of shader output
+    GPixel* const src;
+};
+
+#endif // SSSpanBlitter_DEFINED
@@ -0,0 +1,47 @@
+#include "SSStats.h"
+#include <cinttypes>
+
+#if SS_STATS
+thread_local SSStats* gSSCurrentStats = nullptr;
+#endif
+
+static const char* kDrawTypeNames[] = {
+    "clear", "rect", "convexPolygon", "path", "mesh", "quad", "lines", "strokePolygon",
+};
+
+static const char* kBlendModeNames[] = {
+    "clear", "src", "dst", "srcOver", "dstOver", "srcIn", "dstIn",
+    "srcOut", "dstOut", "srcATop", "dstATop", "xor",
+};
+
+static_assert(sizeof(kDrawTypeNames) / sizeof(kDrawTypeNames[0]) == static_cast<int>(SSDrawType::kCount), "a name per draw type");
+
+void SSStats_print(const SSStats& stats, FILE* file, const char prefix[]) {
+    auto print = [&](const char name[], const char detail[], uint64_t value) {
+        if (value == 0) return;
+
+        if (detail) {
+            fprintf(file, "%s%s.%s %" PRIu64 "\n", prefix, name, detail, value);
+        } else {
+            fprintf(file, "%s%s %" PRIu64 "\n", prefix, name, value);
+        }
+    };
+
+    for (int i = 0; i < static_cast<int>(SSDrawType::kCount); i++) {
+        print("draws", kDrawTypeNames[i], stats.draws[i]);
+    }
+
+    print("edgesBuilt", nullptr, stats.edgesBuilt);
+    print("edgesClipped", nullptr, stats.edgesClipped);
+    print("scanlines", nullptr, stats.scanlines);
+    print("spans", nullptr, stats.spans);
+    print("pixelsShaded", nullptr, stats.pixelsShaded);
+
+    for (int i = 0; i < 12; i++) {
+        print("pixelsBlended", kBlendModeNames[i], stats.pixelsBlended[i]);
+    }
+
+    print("setContextCalls", nullptr, stats.setContextCalls);
+    print("matrixInversions", nullptr, stats.matrixInversions);
+    print("trianglesRasterized", nullptr, stats.trianglesRasterized);
+}
@@ -0,0 +1,89 @@
+#ifndef SSStats_DEFINED
+#define SSStats_DEFINED
+
+#include <cstdint>
+#include <cstdio>
+
+/// Rendering counters are opt in: build with -DSS_STATS=1 (the Makefile's debug build does) to
+/// collect them. Otherwise every SS_STAT_ADD compiles to nothing, its arguments included, and
+/// SSCanvas::getStats() stays zero.
+#ifndef SS_STATS
+#define SS_STATS 0
+#endif
+
+/// What a draw call was, for SSStats::draws
+enum class SSDrawType {
+    kClear,
+    kRect,
+    kConvexPolygon,
+    kPath,
+    kMesh,
+    kQuad,
+    kLines,
+    kStrokePolygon,
+    kCount,
+};
+
+/// Counts of the work draw calls did. Nested draws count too: a drawQuad also counts the
+/// drawMesh it turns into.
+struct SSStats {
+    uint64_t draws[static_cast<int>(SSDrawType::kCount)] = {};
+
+    /// Edges kept for scan conversion, and lines that had to be clipped (or were dropped) to
+    /// fit the bitmap first
+    uint64_t edgesBuilt = 0;
+    uint64_t edgesClipped = 0;
+
+    /// Rows rasterizers walked, and the spans they emitted
+    uint64_t scanlines = 0;
+    uint64_t spans = 0;
+
+    uint64_t pixelsShaded = 0;
+
+    /// By GBlendMode, after simplification: the blend that actually ran
+    uint64_t pixelsBlended[12] = {};
+
+    uint64_t setContextCalls = 0;
+    uint64_t matrixInversions = 0;
+    uint64_t trianglesRasterized = 0;
+};
+
+/// Print the nonzero counters, one "prefix name value" line each
+void SSStats_print(const SSStats& stats, FILE* file, const char prefix[]);
+
+#if SS_STATS
+
+/// The counters draw calls on this thread add to: the drawing canvas's, while it draws
+extern thread_local SSStats* gSSCurrentStats;
+
+/// Points gSSCurrentStats at a canvas's counters for one draw call, and counts the call. Scopes
+/// nest, restoring the outer draw's counters when they end.
+class SSStatsScope {
+public:
+    SSStatsScope(SSStats& stats, SSDrawType type) : previous(gSSCurrentStats) {
+        gSSCurrentStats = &stats;
+        stats.draws[static_cast<int>(type)] += 1;
+    }
+
+    ~SSStatsScope() {
+        gSSCurrentStats = previous;
+    }
+
+    SSStatsScope(const SSStatsScope&) = delete;
+    SSStatsScope& operator=(const SSStatsScope&) = delete;
+
+private:
+    SSStats* const previous;
+};
+
+#define SS_STAT_ADD(field, amount) do { if (gSSCurrentStats) gSSCurrentStats->field += (amount); } while (0)
+#define SS_STATS_DRAW(stats, type) SSStatsScope ssStatsScope(stats, type)
+
+#else
+
+#define SS_STAT_ADD(field, amount) do {} while (0)
+#define SS_STATS_DRAW(stats, type) do {} while (0)
+
+#endif
+
+#endif // SSStats_DEFINED
@@ -0,0 +1,40 @@
+#include "SSStroker.h"
+#include "include/GMath.h"
+
+/// Number of sides that keeps a polygon approximating a circle of this radius within a quarter
+/// pixel of it, clamped to [kSSStrokerMinCircleSegments, kSSStrokerMaxCircleSegments].
+int SSStrokerCircleSegments(float radius) {
+    // A side spanning angle t strays r * (1 - cos(t / 2)) from the circle
+    const float tolerance = 0.25f;
+    if (radius <= tolerance) return kSSStrokerMinCircleSegments;
+
+    float segments = gFloatPI / acosf(1 - tolerance / radius);
+    return std::max(kSSStrokerMinCircleSegments, std::min(kSSStrokerMaxCircleSegments, GCeilToInt(segments)));
+}
+
+/// Every unit circle SSStrokerCircleSegments can ask for, built together the first time one is
+/// needed. Function statics are initialized exactly once even with threads racing to them, and
+/// are read-only afterwards.
+struct SSStrokerUnitCircles {
+    std::vector<GPoint> circles[kSSStrokerMaxCircleSegments + 1];
+
+    SSStrokerUnitCircles() {
+        for (int segments = kSSStrokerMinCircleSegments; segments <= kSSStrokerMaxCircleSegments; segments++) {
+            std::vector<GPoint>& circle = circles[segments];
+            circle.resize(segments);
+
+            // Sweep clockwise in math terms, which is counter-clockwise once y points down
+            for (int i = 0; i < segments; i++) {
+                float angle = -2 * gFloatPI * i / segments;
+                circle[i] = { cosf(angle), sinf(angle) };
+            }
+        }
+    }
+};
+
+const GPoint* SSStrokerUnitCircle(int segments) {
+    assert(segments >= kSSStrokerMinCircleSegments && segments <= kSSStrokerMaxCircleSegments);
+
+    static const SSStrokerUnitCircles unitCircles;
+    return unitCircles.circles[segments].data();
+}
@@ -0,0 +1,84 @@
+#ifndef SSStroker_DEFINED
+#define SSStroker_DEFINED
+
+#include "include/GMath.h"
+#include "include/GPoint.h"
+#include "include/GRect.h"
+#include "SSStats.h"
+#include <vector>
+
+/// Fewest and most sides a round join or cap is approximated with
+constexpr int kSSStrokerMinCircleSegments = 16;
+constexpr int kSSStrokerMaxCircleSegments = 128;
+
+/// Number of sides that keeps a polygon approximating a circle of this radius within a quarter
+/// pixel of it, clamped to [kSSStrokerMinCircleSegments, kSSStrokerMaxCircleSegments].
+int SSStrokerCircleSegments(float radius);
+
+/// The unit circle as a polygon with segments sides, in [kSSStrokerMinCircleSegments,
+/// kSSStrokerMaxCircleSegments]. Every count is built together on first use; safe from any thread.
+/// Like every stroker piece, it winds with negative area (counter-clockwise with y down), so
+/// that overlapping pieces union under non-zero winding instead of cancelling out.
+const GPoint* SSStrokerUnitCircle(int segments);
+
+/// Write the 4 corners of the rectangle that strokes the segment p0 -> p1 with the given
+/// radius (half the stroke width) into quad, wound like every other stroker piece. Returns
+/// false, writing nothing, if the segment has no length.
+static inline bool SSStrokerSegmentQuad(GPoint p0, GPoint p1, float radius, GPoint quad[4]) {
+    GPoint direction = p1 - p0;
+    float length = sqrtf(direction.x * direction.x + direction.y * direction.y);
+    if (length == 0) return false;
+
+    GPoint normal = (radius / length) * GPoint{ -direction.y, direction.x };
+
+    quad[0] = p0 + normal;
+    quad[1] = p1 + normal;
+    quad[2] = p1 - normal;
+    quad[3] = p0 - normal;
+    return true;
+}
+
+/// Break the stroke of the polygon pts into convex pieces: call segment(quad) with the
+/// rectangle of every segment, and join(center) for every point, which gets a round join (or, at
+/// the ends of open polygons, a round cap) of the same radius.
+template <typename SegmentFunction, typename JoinFunction>
+void SSStrokerForEachPiece(
+    const GPoint pts[],
+    int count,
+    float radius,
+    bool isClosed,
+    SegmentFunction segment,
+    JoinFunction join
+) {
+    GPoint quad[4];
+    int segmentCount = isClosed ? count : count - 1;
+
+    for (int i = 0; i < segmentCount; i++) {
+        if (SSStrokerSegmentQuad(pts[i], pts[(i + 1) % count], radius, quad)) segment(quad);
+    }
+
+    for (int i = 0; i < count; i++) {
+        join(pts[i]);
+    }
+}
+
+/// Call blitRow(left, right, y) for each row of pixels [left, right) whose centers are inside
+/// the circle, clipped to clip. Pixel centers exactly on the circle are inside.
+template <typename BlitRowFunction>
+void SSStrokerRasterizeDisc(GPoint center, float radius, const GIRect& clip, BlitRowFunction blitRow) {
+    int top = std::max(clip.top, GCeilToInt(center.y - radius - 0.5f));
+    int bottom = std::min(clip.bottom, GFloorToInt(center.y + radius - 0.5f) + 1);
+
+    SS_STAT_ADD(scanlines, std::max(0, bottom - top));
+    for (int y = top; y < bottom; y++) {
+        float dy = y + 0.5f - center.y;
+        float halfWidth = sqrtf(std::max(0.0f, radius * radius - dy * dy));
+
+        int left = std::max(clip.left, GCeilToInt(center.x - halfWidth - 0.5f));
+        int right = std::min(clip.right, GFloorToInt(center.x + halfWidth - 0.5f) + 1);
+
+        if (left < right) blitRow(left, right, y);
+    }
+}
+
+#endif // SSStroker_DEFINED
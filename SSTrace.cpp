@@ -0,0 +1,105 @@
+#include "SSTrace.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> gSSTraceEnabled(false);
+
+struct SSTraceEvent {
+    const char* name;
+    GNSec start;
+    GNSec duration;
+};
+
+/// One thread's events, and the lane they are drawn on
+struct SSTraceThread {
+    int id;
+    std::vector<SSTraceEvent> events;
+};
+
+/// Every thread that has recorded, kept after the thread exits so its events can still be
+/// written. Guarded by gSSTraceMutex, except each thread appends to its own events unlocked.
+static std::mutex gSSTraceMutex;
+static std::vector<std::shared_ptr<SSTraceThread>> gSSTraceThreads;
+static GNSec gSSTraceStart = 0;
+
+static SSTraceThread& currentThread() {
+    thread_local std::shared_ptr<SSTraceThread> thread;
+
+    if (!thread) {
+        std::lock_guard<std::mutex> lock(gSSTraceMutex);
+
+        thread = std::make_shared<SSTraceThread>();
+        thread->id = static_cast<int>(gSSTraceThreads.size()) + 1;
+        gSSTraceThreads.push_back(thread);
+    }
+
+    return *thread;
+}
+
+void SSTrace_start() {
+    std::lock_guard<std::mutex> lock(gSSTraceMutex);
+
+    for (auto& thread : gSSTraceThreads) {
+        thread->events.clear();
+    }
+
+    gSSTraceStart = GTime::GetNSec();
+    gSSTraceEnabled.store(true, std::memory_order_relaxed);
+}
+
+void SSTrace_addEvent(const char name[], GNSec start, GNSec duration) {
+    currentThread().events.push_back({ name, start, duration });
+}
+
+/// Write s as a JSON string, quotes included
+static void writeString(FILE* file, const char s[]) {
+    fputc('"', file);
+
+    for (; *s; s++) {
+        const unsigned char c = static_cast<unsigned char>(*s);
+
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        } else if (c < 0x20) {
+            fprintf(file, "\\u%04x", c);
+        } else {
+            fputc(c, file);
+        }
+    }
+
+    fputc('"', file);
+}
+
+bool SSTrace_stopAndWrite(const char path[]) {
+    gSSTraceEnabled.store(false, std::memory_order_relaxed);
+
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    std::lock_guard<std::mutex> lock(gSSTraceMutex);
+
+    // Complete ("X") events, with times in microseconds from SSTrace_start
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+
+    for (const auto& thread : gSSTraceThreads) {
+        // Lanes are named in the order threads first recorded
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                first ? "" : ",\n", thread->id, thread->id);
+        first = false;
+
+        for (const SSTraceEvent& event : thread->events) {
+            fprintf(file, ",\n{\"name\":");
+            writeString(file, event.name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    thread->id,
+                    static_cast<double>(event.start - gSSTraceStart) / 1000,
+                    static_cast<double>(event.duration) / 1000);
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
@@ -0,0 +1,53 @@
+#ifndef SSTrace_DEFINED
+#define SSTrace_DEFINED
+
+#include "include/GTime.h"
+#include <atomic>
+
+/// Recording for Chrome's trace-event format (chrome://tracing, or ui.perfetto.dev): timed
+/// zones, on one lane per thread, saved as JSON by SSTrace_stopAndWrite.
+///
+/// Recording is off until SSTrace_start(). While it is off a zone costs one relaxed load, so
+/// zones belong around phases of work (a draw, its edge building, a batch of spans), not pixels.
+
+/// Whether zones are being recorded. Use SSTrace_isEnabled().
+extern std::atomic<bool> gSSTraceEnabled;
+
+static inline bool SSTrace_isEnabled() {
+    return gSSTraceEnabled.load(std::memory_order_relaxed);
+}
+
+/// Throw away anything recorded so far and start recording.
+void SSTrace_start();
+
+/// Stop recording and write every thread's events to path as trace-event JSON. Threads that
+/// recorded must not be recording anymore (joined, or between zones). Returns false if the file
+/// can't be written.
+bool SSTrace_stopAndWrite(const char path[]);
+
+/// Record that name ran on this thread for duration nanoseconds from start (GTime::GetNSec).
+/// name must outlive the recording: a string literal, or a GDrawRec's name.
+void SSTrace_addEvent(const char name[], GNSec start, GNSec duration);
+
+/// Records the time from its construction to its destruction, on this thread, as name. Zones
+/// on one thread must nest, which scopes always do.
+class SSTraceZone {
+public:
+    explicit SSTraceZone(const char name[])
+        : name(SSTrace_isEnabled() ? name : nullptr)
+        , start(this->name ? GTime::GetNSec() : 0)
+    {}
+
+    ~SSTraceZone() {
+        if (name) SSTrace_addEvent(name, start, GTime::GetNSec() - start);
+    }
+
+    SSTraceZone(const SSTraceZone&) = delete;
+    SSTraceZone& operator=(const SSTraceZone&) = delete;
+
+private:
+    const char* const name;
+    const GNSec start;
+};
+
+#endif // SSTrace_DEFINED
@@ -0,0 +1,212 @@
+#ifndef SSTriangle_DEFINED
+#define SSTriangle_DEFINED
+
+#include "include/GPoint.h"
+#include "include/GRect.h"
+#include "SSStats.h"
+
+/// Vertices are snapped to 1/256th of a pixel (24.8 fixed point) before the edges are set up.
+constexpr int kSSTriangleSubpixelBits = 8;
+
+/// Largest device coordinate, in pixels, that can be snapped without the edge functions
+/// overflowing an int64_t. Triangles that reach past it are set up in double precision instead.
+constexpr float kSSTriangleGuardBand = 1 << 21;
+
+/// Floor of n / d, for d > 0
+static inline int64_t SSFloorDivide(int64_t n, int64_t d) {
+    int64_t quotient = n / d;
+    return (n % d != 0 && n < 0) ? quotient - 1 : quotient;
+}
+
+static inline double SSFloorDivide(double n, double d) {
+    return floor(n / d);
+}
+
+/// Tracks floor(n / divisor) and ceil(n / divisor) while n steps by a constant amount each row,
+/// keeping the quotient and remainder so that no division happens after setup.
+template <typename T>
+struct SSTriangleEdgeStepper {
+    T quotient;
+    T remainder;
+    T divisor;
+    T quotientStep;
+    T remainderStep;
+
+    void init(T n, T divisor, T nStep) {
+        this->divisor = divisor;
+        quotient = SSFloorDivide(n, divisor);
+        remainder = n - quotient * divisor;
+        quotientStep = SSFloorDivide(nStep, divisor);
+        remainderStep = nStep - quotientStep * divisor;
+    }
+
+    T floor() const { return quotient; }
+    T ceil() const { return remainder > 0 ? quotient + 1 : quotient; }
+
+    void advance() {
+        quotient += quotientStep;
+        remainder += remainderStep;
+
+        if (remainder >= divisor) {
+            remainder -= divisor;
+            quotient += 1;
+        }
+    }
+};
+
+/// Shared implementation of SSRasterizeConvex (triangles, and strokePolygon's segment quads), for
+/// either fixed point (int64_t, with one pixel == one) or double (one == 1) vertex coordinates.
+///
+/// Each edge i -> j is the half-plane a*x + b*y + c >= 0, oriented so the polygon is inside all
+/// of them. Pixel centers exactly on an edge are only inside if it is a top or left edge, so a
+/// center on an edge shared by two triangles belongs to exactly one of them.
+template <int MaxPoints, typename T, typename BlitRowFunction>
+void SSRasterizeConvexCommon(
+    T xs[],
+    T ys[],
+    int count,
+    const T one,
+    const T smallestStep,
+    int top,
+    int bottom,
+    const GIRect& clip,
+    BlitRowFunction blitRow
+) {
+    // Twice the signed area, as a fan around the first point so no partial sum can overflow
+    T area = 0;
+    for (int i = 1; i < count - 1; i++) {
+        area += (xs[i] - xs[0]) * (ys[i + 1] - ys[0]) - (ys[i] - ys[0]) * (xs[i + 1] - xs[0]);
+    }
+
+    // Skip zero area polygons, and make every polygon clockwise on screen (y points down)
+    if (area == 0) return;
+
+    if (area < 0) {
+        std::reverse(xs, xs + count);
+        std::reverse(ys, ys + count);
+    }
+
+    const T half = one / 2;
+    const T centerY = top * one + half;
+
+    // Along a row, edge i is inside where step * x + offset >= 0 (x in whole pixels), and offset
+    // grows by offsetStep each row. Edges heading down bound the row on the left, edges heading
+    // up bound it on the right, and horizontal edges either keep or reject the whole row.
+    SSTriangleEdgeStepper<T> leftEdges[MaxPoints];
+    SSTriangleEdgeStepper<T> rightEdges[MaxPoints];
+    T horizontalOffsets[MaxPoints];
+    T horizontalOffsetSteps[MaxPoints];
+    int leftCount = 0;
+    int rightCount = 0;
+    int horizontalCount = 0;
+
+    for (int i = 0; i < count; i++) {
+        int j = i == count - 1 ? 0 : i + 1;
+        T a = ys[i] - ys[j];
+        T b = xs[j] - xs[i];
+        T c = ys[j] * xs[i] - xs[j] * ys[i];
+
+        // Top-left rule: a top edge is horizontal and heads right, a left edge heads up
+        bool isTopLeft = a > 0 || (a == 0 && b > 0);
+        if (!isTopLeft) c -= smallestStep;
+
+        T step = a * one;
+        T offset = a * half + b * centerY + c;
+        T offsetStep = b * one;
+
+        if (step > 0) {
+            // x >= ceil(-offset / step)
+            leftEdges[leftCount++].init(-offset, step, -offsetStep);
+        } else if (step < 0) {
+            // x <= floor(offset / -step)
+            rightEdges[rightCount++].init(offset, -step, offsetStep);
+        } else {
+            horizontalOffsets[horizontalCount] = offset;
+            horizontalOffsetSteps[horizontalCount++] = offsetStep;
+        }
+    }
+
+    const T firstColumn = clip.left;
+    const T lastColumn = clip.right - 1;
+
+    SS_STAT_ADD(scanlines, std::max(0, bottom - top));
+    for (int y = top; y < bottom; y++) {
+        T left = firstColumn;
+        T right = lastColumn;
+
+        for (int i = 0; i < leftCount; i++) {
+            left = std::max(left, leftEdges[i].ceil());
+            leftEdges[i].advance();
+        }
+
+        for (int i = 0; i < rightCount; i++) {
+            right = std::min(right, rightEdges[i].floor());
+            rightEdges[i].advance();
+        }
+
+        for (int i = 0; i < horizontalCount; i++) {
+            if (horizontalOffsets[i] < 0) right = left - 1;
+            horizontalOffsets[i] += horizontalOffsetSteps[i];
+        }
+
+        if (left <= right) {
+            blitRow(static_cast<int>(left), static_cast<int>(right) + 1, y);
+        }
+    }
+}
+
+/// Snap points into fixed point (or, outside the guard band, double) coordinates and rasterize
+/// them with SSRasterizeConvexCommon.
+template <int MaxPoints, typename BlitRowFunction>
+void SSRasterizeConvex(const GPoint points[], int count, const GIRect& clip, BlitRowFunction blitRow) {
+    // Find the rows the polygon could touch, and exit early if it misses the clip
+    float minX = points[0].x, maxX = points[0].x;
+    float minY = points[0].y, maxY = points[0].y;
+
+    for (int i = 1; i < count; i++) {
+        minX = std::min(minX, points[i].x);
+        maxX = std::max(maxX, points[i].x);
+        minY = std::min(minY, points[i].y);
+        maxY = std::max(maxY, points[i].y);
+    }
+
+    if (maxX < clip.left || minX > clip.right || maxY < clip.top || minY > clip.bottom) return;
+
+    int top = std::max(clip.top, GFloorToInt(std::max(minY, (float) clip.top)));
+    int bottom = std::min(clip.bottom, GCeilToInt(std::min(maxY, (float) clip.bottom)) + 1);
+
+    bool insideGuardBand =
+        -kSSTriangleGuardBand < minX && maxX < kSSTriangleGuardBand &&
+        -kSSTriangleGuardBand < minY && maxY < kSSTriangleGuardBand;
+
+    if (insideGuardBand) {
+        const float scale = 1 << kSSTriangleSubpixelBits;
+        int64_t xs[MaxPoints], ys[MaxPoints];
+
+        for (int i = 0; i < count; i++) {
+            xs[i] = GRoundToInt(points[i].x * scale);
+            ys[i] = GRoundToInt(points[i].y * scale);
+        }
+
+        SSRasterizeConvexCommon<MaxPoints, int64_t>(xs, ys, count, 1 << kSSTriangleSubpixelBits, 1, top, bottom, clip, blitRow);
+    } else {
+        double xs[MaxPoints], ys[MaxPoints];
+
+        for (int i = 0; i < count; i++) {
+            xs[i] = points[i].x;
+            ys[i] = points[i].y;
+        }
+
+        // Exact ties are vanishingly rare at this scale, so edges aren't biased
+        SSRasterizeConvexCommon<MaxPoints, double>(xs, ys, count, 1.0, 0.0, top, bottom, clip, blitRow);
+    }
+}
+
+/// Call blitRow(left, right, y) for each row of pixels [left, right) whose centers are inside the
+/// triangle with the given device space points, clipped to clip. Does not allocate.
+template <typename BlitRowFunction>
+void SSRasterizeTriangle(const GPoint points[3], const GIRect& clip, BlitRowFunction blitRow) {
+    SSRasterizeConvex<3>(points, 3, clip, blitRow);
+}
+
+#endif // SSTriangle_DEFINED
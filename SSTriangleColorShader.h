@@ -4,8 +4,10 @@
 #include "include/GMatrix.h"
 #include "include/GShader.h"
 #include "SSBlendModeHelpers.h"
+#include "SSShader.h"
+#include "SSVector.h"
 
-class SSTriangleColorShader : public GShader {
+class SSTriangleColorShader : public SSShader {
 public:
     SSTriangleColorShader(
         const GPoint p0,
@@ -24,6 +26,7 @@ public:
     {
         // Build unit space –> device coordinates matrix
         this->unitToDeviceMatrix = GMatrix(p1 - p0, p2 - p0, p0);
+        updateColors();
     }
 
     void updateShader(
@@ -41,11 +44,28 @@ public:
         this->color1 = color1;
         this->color2 = color2;
         this->unitToDeviceMatrix = GMatrix(p1 - p0, p2 - p0, p0);
+        updateColors();
+    }
+
+    /// Point this shader at a new triangle, given its plane equations: the matrix that maps
+    /// device space to the triangle's unit (barycentric) space. Used by drawMesh, which maps the
+    /// vertices by the CTM itself, in place of updateShader() and setContext().
+    void setTriangle(
+        const GMatrix& deviceToUnit,
+        const GColor color0,
+        const GColor color1,
+        const GColor color2
+    ) {
+        this->color0 = color0;
+        this->color1 = color1;
+        this->color2 = color2;
+        this->inverseMatrix = deviceToUnit;
+        updateColors();
     }
 
     /// Return true iff all of the GPixels that may be returned by this shader will be opaque.
     bool isOpaque() override {
-        return color0.a == 1 && color1.a == 1 && color2.a == 1;
+        return colorsAreOpaque;
     }
 
     /// The draw calls in GCanvas must call this with the CTM before any calls to shadeSpan().
@@ -64,13 +84,58 @@ public:
     /// corresponding src pixels in row[0...count - 1]. The caller must ensure that row[]
     /// can hold at least [count] entries.
     void shadeRow(int x, int y, int count, GPixel row[]) override {
-        if (isOpaque()) {
-            shadeRowCommon(x, y, count, row, colorToPixelOpaque);
+        // Premultiplied color at the first pixel center, and its change from one pixel to the next
+        float unitX = (inverseMatrix[0] * (x + 0.5f)) + (inverseMatrix[2] * (y + 0.5f)) + inverseMatrix[4];
+        float unitY = (inverseMatrix[1] * (x + 0.5f)) + (inverseMatrix[3] * (y + 0.5f)) + inverseMatrix[5];
+
+        float weight0 = GPinToUnit(1 - unitX - unitY);
+        float weight1 = GPinToUnit(unitX);
+        float weight2 = GPinToUnit(unitY);
+
+        GColor color = (weight0 * premulColor0) + (weight1 * premulColor1) + (weight2 * premulColor2);
+        GColor colorStep =
+            (premulColor0 * (-inverseMatrix[0] - inverseMatrix[1])) +
+            (premulColor1 * inverseMatrix[0]) +
+            (premulColor2 * inverseMatrix[1]);
+
+        // Channels are stepped in 16.16 fixed point, with 255 as one. The vector kernel keeps them
+        // in 32 bit lanes, so it is only used when no lane can leave [-2^30, 2^30] along the row.
+        const float fixedScale = 255.0f * (1 << 16);
+        const float fixedLimit = 1 << 30;
+
+        const float channels[4] = { color.r, color.g, color.b, color.a };
+        const float channelSteps[4] = { colorStep.r, colorStep.g, colorStep.b, colorStep.a };
+
+        int64_t start[4];
+        int64_t step[4];
+        bool fitsInLanes = true;
+
+        for (int i = 0; i < 4; i++) {
+            float fixedStart = channels[i] * fixedScale;
+            float fixedStep = channelSteps[i] * fixedScale;
+            float fixedEnd = fixedStart + fixedStep * (count + 2 * kSSVectorLanes);
+            fitsInLanes = fitsInLanes && fabs(fixedStart) < fixedLimit && fabs(fixedEnd) < fixedLimit;
+
+            start[i] = static_cast<int64_t>(fixedStart);
+            step[i] = static_cast<int64_t>(fixedStep);
+        }
+
+        if (fitsInLanes) {
+            if (colorsAreOpaque) {
+                shadeRowVector<true>(count, row, start, step);
+            } else {
+                shadeRowVector<false>(count, row, start, step);
+            }
         } else {
-            shadeRowCommon(x, y, count, row, colorToPixel);
+            shadeRowScalar(count, row, start, step);
         }
     }
 
+    /// Contribute a single sample stage, which shades each chunk without a virtual call.
+    void appendStages(SSPipeline& pipeline) override {
+        pipeline.append(sampleStage, this);
+    }
+
 private:
     GPoint p0;
     GPoint p1;
@@ -79,35 +144,105 @@ private:
     GColor color1;
     GColor color2;
 
+    bool colorsAreOpaque;
+    GColor premulColor0;
+    GColor premulColor1;
+    GColor premulColor2;
+
     GMatrix unitToDeviceMatrix;
     GMatrix inverseMatrix;
 
-    template <typename ColorToPixelFunction>
-    void shadeRowCommon(
-        int x,
-        int y,
-        int count,
-        GPixel row[],
-        ColorToPixelFunction colorToPixelFunction
-    ) {
-        float unitX = (inverseMatrix[0] * (x + 0.5f)) + (inverseMatrix[2] * (y + 0.5f)) + inverseMatrix[4];
-        float unitY = (inverseMatrix[1] * (x + 0.5f)) + (inverseMatrix[3] * (y + 0.5f)) + inverseMatrix[5];
+    static void sampleStage(SSPipelineRegisters& registers, void* context) {
+        SSTriangleColorShader* shader = static_cast<SSTriangleColorShader*>(context);
+        shader->SSTriangleColorShader::shadeRow(registers.x, registers.y, registers.count, registers.src);
+    }
 
-        float weight0 = GPinToUnit(1 - unitX - unitY);
-        float weight1 = GPinToUnit(unitX);
-        float weight2 = GPinToUnit(unitY);
+    /// Cache what every row of this triangle needs: opacity, and the premultiplied colors.
+    void updateColors() {
+        colorsAreOpaque = color0.a == 1 && color1.a == 1 && color2.a == 1;
+
+        auto premultiply = [](const GColor& color) {
+            return GColor::RGBA(color.r * color.a, color.g * color.a, color.b * color.a, color.a);
+        };
+
+        premulColor0 = premultiply(color0);
+        premulColor1 = premultiply(color1);
+        premulColor2 = premultiply(color2);
+    }
+
+    /// Round a 16.16 fixed point channel to 0...255, clamped to [0, max]
+    static inline int32_t fixedToChannel(int64_t fixed, int64_t max) {
+        return static_cast<int32_t>((std::max<int64_t>(0, std::min(fixed, max)) + (1 << 15)) >> 16);
+    }
+
+    /// Kernel: two vectors, so 2 * kSSVectorLanes pixels, per iteration. Channels are clamped to
+    /// [0, alpha] so every pixel is a valid premultiplied color, then rounded and packed.
+    template <bool IsOpaque>
+    void shadeRowVector(int count, GPixel row[], const int64_t start[4], const int64_t step[4]) {
+        constexpr int pixelsPerIteration = 2 * kSSVectorLanes;
 
-        GColor color = (weight0 * color0) + (weight1 * color1) + (weight2 * color2);
-        
-        GColor color0Step = color0 * (-inverseMatrix[0] - inverseMatrix[1]);
-        GColor color1Step = color1 * inverseMatrix[0];
-        GColor color2Step = color2 * inverseMatrix[1];
+        const SSInt32x4 zero = SSInt32x4{};
+        const SSInt32x4 half = zero + (1 << 15);
+        const SSInt32x4 fixedOne = zero + (255 << 16);
 
-        GColor colorStep = color0Step + color1Step + color2Step;
+        // Lanes of the first half of each iteration, and the step from one iteration to the next
+        SSInt32x4 channels[4];
+        SSInt32x4 iterationSteps[4];
+
+        for (int c = 0; c < 4; c++) {
+            channels[c] = (int32_t) start[c] + SSInt32x4_iota() * (int32_t) step[c];
+            iterationSteps[c] = zero + (int32_t) (step[c] * pixelsPerIteration);
+        }
+
+        const SSInt32x4 halfSteps[4] = {
+            zero + (int32_t) (step[0] * kSSVectorLanes),
+            zero + (int32_t) (step[1] * kSSVectorLanes),
+            zero + (int32_t) (step[2] * kSSVectorLanes),
+            zero + (int32_t) (step[3] * kSSVectorLanes),
+        };
+
+        auto pack = [&](SSInt32x4 r, SSInt32x4 g, SSInt32x4 b, SSInt32x4 a) {
+            SSInt32x4 maxChannel = IsOpaque ? fixedOne : SSInt32x4_max(zero, SSInt32x4_min(a, fixedOne));
+
+            SSUInt32x4 pixelR = (SSUInt32x4) ((SSInt32x4_max(zero, SSInt32x4_min(r, maxChannel)) + half) >> 16);
+            SSUInt32x4 pixelG = (SSUInt32x4) ((SSInt32x4_max(zero, SSInt32x4_min(g, maxChannel)) + half) >> 16);
+            SSUInt32x4 pixelB = (SSUInt32x4) ((SSInt32x4_max(zero, SSInt32x4_min(b, maxChannel)) + half) >> 16);
+            SSUInt32x4 pixelA = (SSUInt32x4) ((maxChannel + half) >> 16);
+
+            return (pixelA << GPIXEL_SHIFT_A) |
+                   (pixelR << GPIXEL_SHIFT_R) |
+                   (pixelG << GPIXEL_SHIFT_G) |
+                   (pixelB << GPIXEL_SHIFT_B);
+        };
+
+        for (int i = 0; i < count; i += pixelsPerIteration) {
+            SSUInt32x4 pixels[2] = {
+                pack(channels[0], channels[1], channels[2], channels[3]),
+                pack(channels[0] + halfSteps[0], channels[1] + halfSteps[1],
+                     channels[2] + halfSteps[2], channels[3] + halfSteps[3]),
+            };
+
+            int lanes = std::min(pixelsPerIteration, count - i);
+            memcpy(&row[i], pixels, lanes * sizeof(GPixel));
+
+            for (int c = 0; c < 4; c++) {
+                channels[c] += iterationSteps[c];
+            }
+        }
+    }
+
+    /// Same as shadeRowVector, one pixel at a time in 64 bits, for rows long or steep enough
+    /// that the lanes could overflow.
+    void shadeRowScalar(int count, GPixel row[], const int64_t start[4], const int64_t step[4]) {
+        const int64_t fixedOne = 255 << 16;
 
         for (int i = 0; i < count; i++) {
-            row[i] = colorToPixelFunction(color);
-            color += colorStep;
+            int64_t a = colorsAreOpaque ? fixedOne : std::max<int64_t>(0, std::min(start[3] + i * step[3], fixedOne));
+            int32_t r = fixedToChannel(start[0] + i * step[0], a);
+            int32_t g = fixedToChannel(start[1] + i * step[1], a);
+            int32_t b = fixedToChannel(start[2] + i * step[2], a);
+
+            row[i] = GPixel_PackARGB(fixedToChannel(a, fixedOne), r, g, b);
         }
     }
 };
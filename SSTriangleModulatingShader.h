@@ -6,8 +6,9 @@
 #include "SSTriangleColorShader.h"
 #include "SSTriangleTextureShader.h"
 #include "SSBlendModeHelpers.h"
+#include "SSShader.h"
 
-class SSTriangleModulatingShader : public GShader {
+class SSTriangleModulatingShader : public SSShader {
 public:
     std::shared_ptr<SSTriangleColorShader> colorShader;
     std::shared_ptr<SSTriangleTextureShader> textureShader;
@@ -18,7 +19,19 @@ public:
     )
         : colorShader(colorShader)
         , textureShader(textureShader)
-    {}
+    {
+        // Fuse color sampling, texture sampling and modulation into one pipeline
+        appendStages(pipeline);
+
+        // A deeply nested texture can run out of stages: shade it on its own instead
+        if (pipeline.hasOverflowed()) {
+            pipeline.reset();
+            colorShader->appendStages(pipeline);
+            pipeline.append(SSPipelineStage_saveToAux);
+            pipeline.append(SSPipelineStage_shadeRow, textureShader.get());
+            pipeline.append(SSPipelineStage_modulate);
+        }
+    }
 
     void updateShader(
         const GPoint p0,
@@ -35,6 +48,20 @@ public:
         textureShader->updateShader(p0, p1, p2, texturePoint0, texturePoint1, texturePoint2);
     }
 
+    /// Point both shaders at a new triangle. See SSTriangleColorShader::setTriangle.
+    bool setTriangle(
+        const GMatrix& deviceToUnit,
+        const GColor color0,
+        const GColor color1,
+        const GColor color2,
+        const GPoint texturePoint0,
+        const GPoint texturePoint1,
+        const GPoint texturePoint2
+    ) {
+        colorShader->setTriangle(deviceToUnit, color0, color1, color2);
+        return textureShader->setTriangle(deviceToUnit, texturePoint0, texturePoint1, texturePoint2);
+    }
+
     /// Return true iff all of the GPixels that may be returned by this shader will be opaque.
     bool isOpaque() override {
         return colorShader->isOpaque() && textureShader->isOpaque();
@@ -49,16 +76,19 @@ public:
     /// corresponding src pixels in row[0...count - 1]. The caller must ensure that row[]
     /// can hold at least [count] entries.
     void shadeRow(int x, int y, int count, GPixel row[]) override {
-        GPixel row1[count];
-        GPixel row2[count];
-
-        colorShader->shadeRow(x, y, count, row1);
-        textureShader->shadeRow(x, y, count, row2);
+        pipeline.run(x, y, count, row);
+    }
 
-        for (int i = 0; i < count; i++) {
-            row[i] = blendModulate(row1[i], &row2[i]);
-        }
+    /// color stages -> save to aux -> texture stages -> modulate
+    void appendStages(SSPipeline& pipeline) override {
+        colorShader->appendStages(pipeline);
+        pipeline.append(SSPipelineStage_saveToAux);
+        SSShader_appendStages(pipeline, textureShader.get());
+        pipeline.append(SSPipelineStage_modulate);
     }
+
+private:
+    SSPipeline pipeline;
 };
 
 std::shared_ptr<SSTriangleModulatingShader> SSCreateModulatingShader(
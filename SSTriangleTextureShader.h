@@ -4,8 +4,10 @@
 #include "include/GMatrix.h"
 #include "include/GShader.h"
 #include "SSBlendModeHelpers.h"
+#include "SSShader.h"
+#include "SSStats.h"
 
-class SSTriangleTextureShader : public GShader {
+class SSTriangleTextureShader : public SSShader {
 public:
     SSTriangleTextureShader(
         std::shared_ptr<GShader> baseShader,
@@ -17,6 +19,7 @@ public:
         const GPoint texturePoint2
     ) {
         this->baseShader = baseShader;
+        this->stagedBaseShader = dynamic_cast<SSShader*>(baseShader.get());
 
         // Build unit space –> device coordinates matrix
         this->unitToDeviceMatrix = GMatrix(point1 - point0, point2 - point0, point0);
@@ -40,6 +43,27 @@ public:
         this->unitToTextureMatrix = GMatrix(texturePoint1 - texturePoint0, texturePoint2 - texturePoint0, texturePoint0);
     }
 
+    /// Point this shader at a new triangle, given its plane equations: the matrix that maps
+    /// device space to the triangle's unit (barycentric) space. Used by drawMesh in place of
+    /// updateShader() and setContext(), so that no matrix needs inverting per triangle.
+    bool setTriangle(
+        const GMatrix& deviceToUnit,
+        const GPoint texturePoint0,
+        const GPoint texturePoint1,
+        const GPoint texturePoint2
+    ) {
+        this->unitToTextureMatrix = GMatrix(texturePoint1 - texturePoint0, texturePoint2 - texturePoint0, texturePoint0);
+        GMatrix deviceToTexture = unitToTextureMatrix * deviceToUnit;
+        SS_STAT_ADD(setContextCalls, 1);
+
+        if (stagedBaseShader) {
+            return stagedBaseShader->setInverseContext(deviceToTexture);
+        } else {
+            auto textureToDevice = deviceToTexture.invert();
+            return textureToDevice && baseShader->setContext(textureToDevice.value());
+        }
+    }
+
     /// Return true iff all of the GPixels that may be returned by this shader will be opaque.
     bool isOpaque() override {
         return baseShader->isOpaque();
@@ -64,8 +88,15 @@ public:
         baseShader->shadeRow(x, y, count, row);
     }
 
+    /// This shader only changes the base shader's context, so it contributes the base shader's
+    /// stages directly and adds no stage of its own.
+    void appendStages(SSPipeline& pipeline) override {
+        SSShader_appendStages(pipeline, baseShader.get());
+    }
+
 private:
     std::shared_ptr<GShader> baseShader;
+    SSShader* stagedBaseShader;
     GMatrix unitToDeviceMatrix;
     GMatrix unitToTextureMatrix;
 };
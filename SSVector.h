@@ -0,0 +1,51 @@
+#ifndef SSVector_DEFINED
+#define SSVector_DEFINED
+
+#include <cstdint>
+
+/// Portable SIMD vectors, using the GCC/Clang vector extensions. Arithmetic, shifts and
+/// comparisons work lane by lane. 16 bytes is the baseline register on every target we build
+/// for, so kernels that want more pixels per iteration unroll over several of these.
+constexpr int kSSVectorLanes = 4;
+
+typedef int32_t SSInt32x4 __attribute__((vector_size(16)));
+typedef uint32_t SSUInt32x4 __attribute__((vector_size(16)));
+typedef float SSFloat32x4 __attribute__((vector_size(16)));
+typedef uint8_t SSUInt8x16 __attribute__((vector_size(16)));
+
+/// Put on a hot kernel to have it compiled once per instruction set and picked at load time, so
+/// the same binary runs its 4-lane loops on AVX2 (and the wider unrolls GCC makes of them) where
+/// the CPU has it, and on baseline SSE2 where it doesn't. Only GCC on x86-64 Linux has the
+/// loader support (ifunc); everywhere else the kernel is simply compiled once.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define SS_TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define SS_TARGET_CLONES
+#endif
+
+static inline SSInt32x4 SSInt32x4_min(SSInt32x4 lhs, SSInt32x4 rhs) {
+    return lhs < rhs ? lhs : rhs;
+}
+
+static inline SSInt32x4 SSInt32x4_max(SSInt32x4 lhs, SSInt32x4 rhs) {
+    return lhs > rhs ? lhs : rhs;
+}
+
+static inline SSFloat32x4 SSFloat32x4_splat(float value) {
+    return SSFloat32x4{ value, value, value, value };
+}
+
+static inline SSFloat32x4 SSFloat32x4_min(SSFloat32x4 lhs, SSFloat32x4 rhs) {
+    return lhs < rhs ? lhs : rhs;
+}
+
+static inline SSFloat32x4 SSFloat32x4_max(SSFloat32x4 lhs, SSFloat32x4 rhs) {
+    return lhs > rhs ? lhs : rhs;
+}
+
+/// { 0, 1, 2, 3 }: each lane's offset from the first
+static inline SSInt32x4 SSInt32x4_iota() {
+    return SSInt32x4{ 0, 1, 2, 3 };
+}
+
+#endif // SSVector_DEFINED
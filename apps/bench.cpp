@@ -0,0 +1,422 @@
+/**
+ *  Micro-benchmarks for every drawing primitive, shader, tile mode and blend mode.
+ *
+ *      make bench
+ *      ./bench [--match substring] [--time ms] [--json path]
+ *
+ *  Each benchmark draws the same thing into a 1024x1024 canvas over and over. Its time is the
+ *  fastest of several batches, divided by the pixels its geometry covers (counted once, by
+ *  drawing it opaque with kSrc), to give ns/pixel and pixels/second. --json writes the
+ *  results in a form that can be diffed or compared run to run.
+ */
+
+#include "../include/GBitmap.h"
+#include "../include/GCanvas.h"
+#include "../include/GFinal.h"
+#include "../include/GPaint.h"
+#include "../include/GPathBuilder.h"
+#include "../include/GRect.h"
+#include "../include/GShader.h"
+#include "../include/GTime.h"
+#include "../SSCanvas.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+static constexpr int kCanvasSize = 1024;
+static constexpr float kPi = 3.14159265f;
+
+struct Bench {
+    std::string name;
+
+    /// Draws the benchmark's geometry with paint
+    std::function<void(GCanvas*, const GPaint&)> draw;
+
+    GPaint paint;
+
+    /// The canvas is cleared to this once, before timing. Translucent by default, so blend modes
+    /// can't be simplified for an opaque destination
+    GColor background = GColor::RGBA(0.5f, 0.5f, 0.5f, 0.5f);
+
+    SSPrecision precision = SSPrecision::k8888;
+};
+
+struct BenchResult {
+    std::string name;
+    long pixels;
+    double nsPerDraw;
+};
+
+static double nowNS() {
+    return static_cast<double>(GTime::GetNSec());
+}
+
+// MARK: Geometry
+
+static GPoint pointOnCircle(GPoint center, float radius, float radians) {
+    return { center.x + radius * cosf(radians), center.y + radius * sinf(radians) };
+}
+
+/// count points alternating between the two radii: a star, concave when inner < outer
+static std::vector<GPoint> starPoints(int count, float outer, float inner) {
+    const GPoint center = { kCanvasSize / 2.0f, kCanvasSize / 2.0f };
+    std::vector<GPoint> points;
+
+    for (int i = 0; i < count; i++) {
+        const float radius = i % 2 ? inner : outer;
+        points.push_back(pointOnCircle(center, radius, 2 * kPi * static_cast<float>(i) / static_cast<float>(count)));
+    }
+
+    return points;
+}
+
+/// A flower of count cubic petals
+static std::shared_ptr<GPath> flowerPath(int count) {
+    const GPoint center = { kCanvasSize / 2.0f, kCanvasSize / 2.0f };
+    const float step = 2 * kPi / static_cast<float>(count);
+    GPathBuilder builder;
+
+    builder.moveTo(pointOnCircle(center, 250, 0));
+    for (int i = 0; i < count; i++) {
+        const float angle = step * static_cast<float>(i);
+        builder.cubicTo(pointOnCircle(center, 480, angle + step / 3),
+                        pointOnCircle(center, 480, angle + 2 * step / 3),
+                        pointOnCircle(center, 250, angle + step));
+    }
+
+    return builder.detach();
+}
+
+static const GPoint kQuadVerts[4] = { { 40, 60 }, { 980, 20 }, { 1000, 990 }, { 10, 940 } };
+static const GPoint kQuadTexs[4] = { { 0, 0 }, { 256, 0 }, { 256, 256 }, { 0, 256 } };
+static const GColor kQuadColors[4] = {
+    GColor::RGBA(1, 0, 0, 1), GColor::RGBA(0, 1, 0, 1), GColor::RGBA(0, 0, 1, 1), GColor::RGBA(1, 1, 0, 1)
+};
+
+/// A 256x256 opaque texture for the bitmap shaders
+static GBitmap makeTexture() {
+    GBitmap bitmap;
+    bitmap.alloc(256, 256);
+
+    for (int y = 0; y < 256; y++) {
+        for (int x = 0; x < 256; x++) {
+            const int check = ((x >> 5) ^ (y >> 5)) & 1 ? 255 : 64;
+            *bitmap.getAddr(x, y) = GPixel_PackARGB(255, x, check, y);
+        }
+    }
+
+    bitmap.setIsOpaque(GBitmap::kYes_IsOpaque);
+    return bitmap;
+}
+
+// MARK: Benchmarks
+
+static const char* kBlendModeNames[] = {
+    "clear", "src", "dst", "srcover", "dstover", "srcin", "dstin",
+    "srcout", "dstout", "srcatop", "dstatop", "xor",
+};
+
+static const char* kTileModeNames[] = { "clamp", "repeat", "mirror" };
+
+static std::vector<Bench> makeBenches(const GBitmap& texture) {
+    std::vector<Bench> benches;
+    const GPaint opaque(GColor::RGBA(0.2f, 0.6f, 0.9f, 1));
+    const GPaint translucent(GColor::RGBA(0.2f, 0.6f, 0.9f, 0.5f));
+    const GRect full = GRect::WH(kCanvasSize, kCanvasSize);
+
+    // drawRect, by size
+    for (int size : { 16, 64, 256, 1024 }) {
+        const GRect rect = GRect::XYWH(0, 0, static_cast<float>(size), static_cast<float>(size));
+        auto draw = [rect](GCanvas* canvas, const GPaint& paint) { canvas->drawRect(rect, paint); };
+
+        benches.push_back({ "rect_" + std::to_string(size) + "_opaque", draw, opaque });
+        benches.push_back({ "rect_" + std::to_string(size) + "_translucent", draw, translucent });
+    }
+
+    // drawConvexPolygon, by edge count
+    for (int count : { 3, 8, 64 }) {
+        const std::vector<GPoint> points = starPoints(count, 500, 500);
+        benches.push_back({ "convexpoly_" + std::to_string(count), [points](GCanvas* canvas, const GPaint& paint) {
+            canvas->drawConvexPolygon(points.data(), static_cast<int>(points.size()), paint);
+        }, translucent });
+    }
+
+    // drawPath: lines by edge count, and curves by density
+    for (int count : { 8, 64, 512 }) {
+        GPathBuilder builder;
+        const std::vector<GPoint> points = starPoints(count, 500, 200);
+        builder.addPolygon(points.data(), count);
+        std::shared_ptr<GPath> path = builder.detach();
+
+        benches.push_back({ "path_lines_" + std::to_string(count), [path](GCanvas* canvas, const GPaint& paint) {
+            canvas->drawPath(*path, paint);
+        }, translucent });
+    }
+
+    for (int count : { 4, 16, 64 }) {
+        std::shared_ptr<GPath> path = flowerPath(count);
+        benches.push_back({ "path_cubics_" + std::to_string(count), [path](GCanvas* canvas, const GPaint& paint) {
+            canvas->drawPath(*path, paint);
+        }, translucent });
+    }
+
+    // drawQuad (so drawMesh), by level: colors, texture, and both
+    const GPaint texturePaint = GPaint(GCreateBitmapShader(texture, GMatrix()));
+    for (int level : { 0, 4, 16, 64 }) {
+        const std::string suffix = "_level_" + std::to_string(level);
+
+        benches.push_back({ "quad_colors" + suffix, [level](GCanvas* canvas, const GPaint& paint) {
+            canvas->drawQuad(kQuadVerts, kQuadColors, nullptr, level, paint);
+        }, opaque });
+        benches.push_back({ "quad_texture" + suffix, [level](GCanvas* canvas, const GPaint& paint) {
+            canvas->drawQuad(kQuadVerts, nullptr, kQuadTexs, level, paint);
+        }, texturePaint });
+        benches.push_back({ "quad_both" + suffix, [level](GCanvas* canvas, const GPaint& paint) {
+            canvas->drawQuad(kQuadVerts, kQuadColors, kQuadTexs, level, paint);
+        }, texturePaint });
+    }
+
+    // Shared, so the coons benchmarks keep it alive
+    std::shared_ptr<GFinal> factory = GCreateFinal();
+    const GPoint coonsPoints[8] = {
+        { 40, 60 }, { 500, -100 }, { 980, 20 }, { 1100, 500 }, { 1000, 990 }, { 500, 800 }, { 10, 940 }, { 200, 500 }
+    };
+    for (int level : { 2, 16 }) {
+        benches.push_back({ "coons_texture_level_" + std::to_string(level), [factory, coonsPoints, level](GCanvas* canvas, const GPaint& paint) {
+            factory->drawQuadraticCoons(canvas, coonsPoints, kQuadTexs, level, paint);
+        }, texturePaint });
+    }
+
+    // Hairlines and strokes
+    const std::vector<GPoint> spokes = [] {
+        std::vector<GPoint> points;
+        const GPoint center = { kCanvasSize / 2.0f, kCanvasSize / 2.0f };
+        for (int i = 0; i < 256; i++) {
+            points.push_back(center);
+            points.push_back(pointOnCircle(center, 500, 2 * kPi * static_cast<float>(i) / 256));
+        }
+        return points;
+    }();
+
+    for (bool antiAlias : { false, true }) {
+        benches.push_back({ antiAlias ? "lines_aa_256" : "lines_256", [spokes, antiAlias](GCanvas* canvas, const GPaint& paint) {
+            static_cast<SSCanvas*>(canvas)->drawLines(spokes.data(), static_cast<int>(spokes.size()), paint, antiAlias);
+        }, translucent });
+    }
+
+    const std::vector<GPoint> strokePoints = starPoints(16, 450, 250);
+    benches.push_back({ "stroke_polygon_16", [strokePoints](GCanvas* canvas, const GPaint& paint) {
+        static_cast<SSCanvas*>(canvas)->strokePolygon(strokePoints.data(), static_cast<int>(strokePoints.size()), 20, true, paint);
+    }, translucent });
+
+    // Each shader, and tile mode, filling the canvas
+    auto fill = [full](GCanvas* canvas, const GPaint& paint) { canvas->drawRect(full, paint); };
+
+    for (int tile = 0; tile < 3; tile++) {
+        const GTileMode mode = static_cast<GTileMode>(tile);
+        const GMatrix scaled = GMatrix::Scale(1.5f, 1.5f);
+        const GMatrix rotated = GMatrix::Translate(512, 512) * GMatrix::Rotate(0.3f) * GMatrix::Scale(0.7f, 0.7f);
+        const GColor colors[] = {
+            GColor::RGBA(1, 0, 0, 1), GColor::RGBA(0, 1, 0, 1), GColor::RGBA(0, 0, 1, 1),
+            GColor::RGBA(1, 1, 0, 1), GColor::RGBA(0, 1, 1, 1)
+        };
+
+        const std::string name = kTileModeNames[tile];
+        benches.push_back({ "shader_bitmap_scaled_" + name, fill, GPaint(GCreateBitmapShader(texture, scaled, mode)) });
+        benches.push_back({ "shader_bitmap_rotated_" + name, fill, GPaint(GCreateBitmapShader(texture, rotated, mode)) });
+        benches.push_back({ "shader_linear_2_" + name, fill, GPaint(GCreateLinearGradient({ 300, 300 }, { 700, 600 }, colors[0], colors[1], mode)) });
+        benches.push_back({ "shader_linear_5_" + name, fill, GPaint(GCreateLinearGradient({ 300, 300 }, { 700, 600 }, colors, 5, mode)) });
+    }
+
+    {
+        const GColor colors[] = {
+            GColor::RGBA(1, 0, 0, 1), GColor::RGBA(0, 1, 0, 1), GColor::RGBA(0, 0, 1, 1), GColor::RGBA(1, 1, 0, 1)
+        };
+        const float positions[] = { 0, 0.2f, 0.7f, 1 };
+        const GPoint sites[] = { { 100, 100 }, { 900, 200 }, { 500, 800 }, { 200, 700 } };
+
+        benches.push_back({ "shader_voronoi_4", fill, GPaint(factory->createVoronoiShader(sites, colors, 4)) });
+        benches.push_back({ "shader_sweep_4", fill, GPaint(factory->createSweepGradient({ 512, 512 }, 0.5f, colors, 4)) });
+        benches.push_back({ "shader_linearpos_4", fill, GPaint(factory->createLinearPosGradient({ 100, 100 }, { 900, 700 }, colors, positions, 4)) });
+
+        // The color matrix shader borrows its real shader, so the lambda keeps it alive
+        std::shared_ptr<GShader> real = GCreateBitmapShader(texture, GMatrix::Scale(4, 4), GTileMode::kRepeat);
+        std::shared_ptr<GShader> matrix = factory->createColorMatrixShader(GColorMatrix({
+            0.4f, 0.3f, 0.3f, 0, 0.3f, 0.4f, 0.3f, 0, 0.3f, 0.3f, 0.4f, 0, 0, 0, 0, 1, 0, 0, 0, 0
+        }), real.get());
+        benches.push_back({ "shader_colormatrix", [fill, real](GCanvas* canvas, const GPaint& paint) {
+            fill(canvas, paint);
+        }, GPaint(matrix) });
+    }
+
+    // Every blend mode, with an opaque and a translucent source
+    const GRect blendRect = GRect::XYWH(0, 0, 512, 512);
+    for (int mode = 0; mode < 12; mode++) {
+        for (bool isOpaque : { true, false }) {
+            GPaint paint = isOpaque ? opaque : translucent;
+            paint.setBlendMode(static_cast<GBlendMode>(mode));
+
+            benches.push_back({
+                std::string("blend_") + kBlendModeNames[mode] + (isOpaque ? "_opaque" : "_translucent"),
+                [blendRect](GCanvas* canvas, const GPaint& paint) { canvas->drawRect(blendRect, paint); },
+                paint
+            });
+        }
+    }
+
+    // kF32, for comparison with the 8 bit blends above
+    for (int mode = 0; mode < 12; mode++) {
+        GPaint paint = translucent;
+        paint.setBlendMode(static_cast<GBlendMode>(mode));
+
+        Bench bench = {
+            std::string("f32_blend_") + kBlendModeNames[mode] + "_translucent",
+            [blendRect](GCanvas* canvas, const GPaint& paint) { canvas->drawRect(blendRect, paint); },
+            paint
+        };
+        bench.precision = SSPrecision::kF32;
+        benches.push_back(bench);
+    }
+
+    return benches;
+}
+
+// MARK: Running
+
+/// Pixels bench's geometry covers, drawn once with its paint made opaque and kSrc. The shader
+/// stays: texture-only meshes draw nothing without one
+static long countCoverage(const Bench& bench) {
+    GBitmap bitmap;
+    bitmap.alloc(kCanvasSize, kCanvasSize);
+
+    GPaint paint = bench.paint;
+    paint.setColor(GColor::RGBA(1, 1, 1, 1));
+    paint.setBlendMode(GBlendMode::kSrc);
+    bench.draw(GCreateCanvas(bitmap).get(), paint);
+
+    long pixels = 0;
+    for (int y = 0; y < kCanvasSize; y++) {
+        for (int x = 0; x < kCanvasSize; x++) {
+            pixels += GPixel_GetA(*bitmap.getAddr(x, y)) != 0;
+        }
+    }
+
+    return pixels;
+}
+
+/// Fastest ns per draw of kBatches batches, each long enough to take about timeMS / kBatches
+static double timeBench(const Bench& bench, GBitmap& bitmap, double timeMS) {
+    constexpr int kBatches = 5;
+
+    auto canvas = GCreateCanvas(bitmap);
+    canvas->clear(bench.background);
+    static_cast<SSCanvas*>(canvas.get())->setPrecision(bench.precision);
+
+    // Warm up, then double the batch size until a batch takes long enough to time
+    bench.draw(canvas.get(), bench.paint);
+
+    const double batchNS = timeMS * 1e6 / kBatches;
+    long draws = 1;
+    double elapsed = 0;
+
+    for (;;) {
+        const double start = nowNS();
+        for (long i = 0; i < draws; i++) bench.draw(canvas.get(), bench.paint);
+        elapsed = nowNS() - start;
+
+        if (elapsed >= batchNS || draws >= (1L << 30)) break;
+        draws *= 2;
+    }
+
+    double best = elapsed / static_cast<double>(draws);
+    for (int batch = 1; batch < kBatches; batch++) {
+        const double start = nowNS();
+        for (long i = 0; i < draws; i++) bench.draw(canvas.get(), bench.paint);
+        best = std::min(best, (nowNS() - start) / static_cast<double>(draws));
+    }
+
+    return best;
+}
+
+static bool writeJSON(const char path[], const std::vector<BenchResult>& results) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "{\n  \"canvas\": [%d, %d],\n  \"benchmarks\": [\n", kCanvasSize, kCanvasSize);
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        const double nsPerPixel = result.pixels ? result.nsPerDraw / static_cast<double>(result.pixels) : 0;
+
+        fprintf(file, "    { \"name\": \"%s\", \"pixels\": %ld, \"ns_per_draw\": %.1f, \"ns_per_pixel\": %.4f, \"pixels_per_second\": %.0f }%s\n",
+                result.name.c_str(), result.pixels, result.nsPerDraw, nsPerPixel,
+                nsPerPixel > 0 ? 1e9 / nsPerPixel : 0, i + 1 < results.size() ? "," : "");
+    }
+
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+static bool is_arg(const char arg[], const char name[]) {
+    std::string str("--");
+    str += name;
+    if (!strcmp(arg, str.c_str())) {
+        return true;
+    }
+
+    char shortVers[3];
+    shortVers[0] = '-';
+    shortVers[1] = name[0];
+    shortVers[2] = 0;
+    return !strcmp(arg, shortVers);
+}
+
+int main(int argc, const char* argv[]) {
+    const char* match = nullptr;
+    const char* jsonPath = nullptr;
+    double timeMS = 250;
+
+    for (int i = 1; i < argc; ++i) {
+        if (is_arg(argv[i], "match") && i+1 < argc) {
+            match = argv[++i];
+        } else if (is_arg(argv[i], "json") && i+1 < argc) {
+            jsonPath = argv[++i];
+        } else if (is_arg(argv[i], "time") && i+1 < argc) {
+            timeMS = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--match substring] [--time ms] [--json path]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const GBitmap texture = makeTexture();
+    GBitmap bitmap;
+    bitmap.alloc(kCanvasSize, kCanvasSize);
+
+    std::vector<BenchResult> results;
+    printf("%-36s %14s %10s %14s\n", "benchmark", "ns/draw", "ns/pixel", "Mpixels/s");
+
+    for (const Bench& bench : makeBenches(texture)) {
+        if (match && !strstr(bench.name.c_str(), match)) continue;
+
+        const long pixels = countCoverage(bench);
+        const double nsPerDraw = timeBench(bench, bitmap, timeMS);
+        const double nsPerPixel = pixels ? nsPerDraw / static_cast<double>(pixels) : 0;
+
+        printf("%-36s %14.1f %10.4f %14.1f\n", bench.name.c_str(), nsPerDraw, nsPerPixel,
+               nsPerPixel > 0 ? 1e3 / nsPerPixel : 0);
+        fflush(stdout);
+
+        results.push_back({ bench.name, pixels, nsPerDraw });
+    }
+
+    if (jsonPath && !writeJSON(jsonPath, results)) {
+        fprintf(stderr, "failed to write %s\n", jsonPath);
+        return 1;
+    }
+
+    return 0;
+}
@@ -6,6 +6,9 @@
 #include "../include/GCanvas.h"
 #include "../include/GColor.h"
 #include "../include/GBitmap.h"
+#include "../SSBitmapAlloc.h"
+#include "../SSCanvas.h"
+#include "../SSTrace.h"
 #include <string>
 
 static int pixel_diff(GPixel p0, GPixel p1) {
@@ -57,8 +60,20 @@ static double compare(const GBitmap& a, const GBitmap& b, int tolerance, bool ve
 
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
-static void handle_proc(const GDrawRec& rec, const char path[], GBitmap* bitmap) {
-    bitmap->alloc(rec.fWidth, rec.fHeight);
+/// Draw rec into bitmap and write it to path. If stats isn't null, it is set to the rendering
+/// counters for rec's draws (all zero unless built with SS_STATS).
+static void handle_proc(const GDrawRec& rec, const char path[], GBitmap* bitmap, SSStats* stats) {
+    SSTraceZone zone(rec.fName);
+
+    // Cleared below, so there's no need to zero it first. The last frame's memory is reused
+    // if it's big enough
+    SSAllocOptions options;
+    options.zero = false;
+    options.pool = &SSPixelPool::Shared();
+    if (!SSBitmap_alloc(bitmap, rec.fWidth, rec.fHeight, options)) {
+        fprintf(stderr, "failed to allocate [%d %d] %s\n", rec.fWidth, rec.fHeight, rec.fName);
+        return;
+    }
 
     auto canvas = GCreateCanvas(*bitmap);
     if (!canvas) {
@@ -68,7 +83,17 @@ static void handle_proc(const GDrawRec& rec, const char path[], GBitmap* bitmap)
     }
 
     canvas->clear({0, 0, 0, 0});
-    rec.fDraw(canvas.get());
+
+    // GCreateCanvas always makes an SSCanvas. Only count the rec's own draws, not the clear
+    SSCanvas* ssCanvas = static_cast<SSCanvas*>(canvas.get());
+    ssCanvas->resetStats();
+
+    {
+        SSTraceZone drawZone("draw");
+        rec.fDraw(canvas.get());
+    }
+
+    if (stats) *stats = ssCanvas->getStats();
 
     if (!bitmap->writeToFile(path)) {
         fprintf(stderr, "failed to write %s\n", path);
@@ -107,9 +132,14 @@ static void add_diff_to_file(FILE* f, const GBitmap& test, const GBitmap& orig,
                              const char name[]) {
     const int w = test.width();
     const int h = test.height();
+    // Every pixel is written below
+    SSAllocOptions options;
+    options.zero = false;
+    options.pool = &SSPixelPool::Shared();
+
     GBitmap diff0, diff1;
-    diff0.alloc(w, h);
-    diff1.alloc(w, h);
+    SSBitmap_alloc(&diff0, w, h, options);
+    SSBitmap_alloc(&diff1, w, h, options);
 
     for (int y = 0; y < h; ++y) {
         for (int x = 0; x < w; ++x) {
@@ -147,6 +177,8 @@ int main_image(int argc, const char* argv[]) {
     const char* expected = NULL;
     const char* diffDir = NULL;
     const char* scoreFile = nullptr;
+    bool printStats = false;
+    const char* tracePath = nullptr;
     FILE* diffFile = NULL;
     int tolerance = 0;
 
@@ -174,6 +206,15 @@ int main_image(int argc, const char* argv[]) {
             assert(tolerance >= 0);
         } else if (is_arg(argv[i], "scoreFile") && i+1 < argc) {
             scoreFile = argv[++i];
+        } else if (!strcmp(argv[i], "--stats")) {
+            // Long form only: -s is --scoreFile
+            printStats = true;
+            if (!SS_STATS) {
+                printf("------- stats are compiled out; build with -DSS_STATS=1\n");
+            }
+        } else if (!strcmp(argv[i], "--trace") && i+1 < argc) {
+            // Long form only: -t is --tolerance
+            tracePath = argv[++i];
         } else if (is_arg(argv[i], "diff") && i+1 < argc) {
             diffDir = argv[++i];
             std::string path(diffDir);
@@ -198,6 +239,10 @@ int main_image(int argc, const char* argv[]) {
         }
     }
 
+    if (tracePath) {
+        SSTrace_start();
+    }
+
     // pa#_NAME.png -- so add 8 to the name length for the total
     const int maxNameLen = max_name_len() + 8;
 
@@ -228,7 +273,8 @@ int main_image(int argc, const char* argv[]) {
         }
         
         GBitmap testBM;
-        handle_proc(gDrawRecs[i], path.c_str(), &testBM);
+        SSStats stats;
+        handle_proc(gDrawRecs[i], path.c_str(), &testBM, printStats ? &stats : nullptr);
 
         if (expected && !something) {
             std::string exp_path(expected);
@@ -254,11 +300,17 @@ int main_image(int argc, const char* argv[]) {
             printf("\n");
         }
 
-        free(testBM.pixels());
+        if (printStats) {
+            printf("stats: %s\n", gDrawRecs[i].fName);
+            SSStats_print(stats, stdout, "    ");
+        }
     }
     if (diffFile) {
         fclose(diffFile);
     }
+    if (tracePath && !SSTrace_stopAndWrite(tracePath)) {
+        printf("------- failed to write trace %s\n", tracePath);
+    }
 
     constexpr double num_required = 2;
 
@@ -6,6 +6,7 @@
 #define GBitmap_DEFINED
 
 #include "GPixel.h"
+#include <memory>
 
 class GBitmap {
 public:
@@ -29,6 +30,7 @@ public:
         fPixels = NULL;
         fRowBytes = 0;
         fIsOpaque = false;  // unknown
+        fStorage.reset();
     }
 
     enum IsOpaque {
@@ -38,6 +40,18 @@ public:
     };
     void reset(int w, int h, size_t rb, GPixel* pixels, IsOpaque);
 
+    /**
+     *  As above, but the pixels belong to storage (a file mapping, say), which copies of the
+     *  bitmap share. It is released when the last of them is reset or destroyed.
+     */
+    void reset(int w, int h, size_t rb, GPixel* pixels, IsOpaque, std::shared_ptr<void> storage);
+
+    /**
+     *  Whatever owns the pixels: set by alloc(), or given to reset(). Empty when the caller
+     *  manages the pixels itself.
+     */
+    const std::shared_ptr<void>& storage() const { return fStorage; }
+
     GPixel* getAddr(int x, int y) const {
         assert(x >= 0 && x < this->width());
         assert(y >= 0 && y < this->height());
@@ -55,10 +69,11 @@ public:
     }
 
     /**
-     *  Attempt to read the png image stored in the named file.
+     *  Attempt to read the image stored in the named file: PNG, or QOI, PAM, PPM or .gbitmap
+     *  chosen by the path's extension (see SSImageFormats.h).
      *
-     *  On success, allocate the memory for the pixels using malloc() and set bitmap to the result,
-     *  returning true. The caller must call free(bitmap->fPixels) when they are finished.
+     *  On success, allocate the memory for the pixels with alloc() and set bitmap to the result,
+     *  returning true.
      *
      *  This automatically computes the opaqueness of the bitmap.
      *
@@ -67,13 +82,16 @@ public:
     bool readFromFile(const char path[]);
 
     /*
-     *  Attempt to write the bitmap as a PNG into a new file (the file will be created/overwritten).
-     *  Return true on success.
+     *  Attempt to write the bitmap into a new file (the file will be created/overwritten), as a
+     *  PNG unless the path ends in .qoi, .pam, .ppm or .gbitmap. Return true on success.
      */
     bool writeToFile(const char path[]) const;
 
     /**
      *  Allocate the memory for the bitmap. If rowBytes is 0, it will be computed from w.
+     *
+     *  The memory belongs to the bitmap's storage(), and is freed once the bitmap and all its
+     *  copies are reset or destroyed. Don't free() it.
      */
     void alloc(int w, int h, size_t rowBytes = 0);
 
@@ -83,6 +101,7 @@ private:
     GPixel* fPixels;
     size_t  fRowBytes;
     bool    fIsOpaque;  // hint that all pixels have 0xFF for alpha
+    std::shared_ptr<void> fStorage;  // keeps fPixels alive, when something other than alloc() made them
 
     void validate() const {
         assert(fWidth >= 0);
@@ -19,14 +19,29 @@ enum class GPathDirection {
     kCCW, // counter-clockwise
 };
 
+enum class GPathShape {
+    kRect,    // one contour: an axis-aligned rectangle
+    kOval,    // one contour: the ellipse inscribed in bounds(), from GPathBuilder::addCircle
+    kConvex,  // one contour: a convex polygon of lines
+    kGeneral, // anything else, including empty paths
+};
+
 class GPath : public std::enable_shared_from_this<GPath> {
 public:
     /**
      *  Return the bounds of all of the control-points in the path.
      *
      *  If there are no points, returns an empty rect (all zeros)
+     *
+     *  Computed once, when the path is made.
      */
-    GRect bounds() const;
+    GRect bounds() const { return fBounds; }
+
+    /**
+     *  Return the kind of shape the path draws, so it can be filled without the general
+     *  winding scan when it is something simpler. Computed once, when the path is made.
+     */
+    GPathShape shape() const { return fShape; }
 
     size_t countPoints() const { return fPts.size(); }
 
@@ -112,9 +127,15 @@ public:
      */
     static void ChopCubicAt(const GPoint src[4], GPoint dst[7], float t);
 
-    GPath(std::vector<GPoint> pts, std::vector<GPathVerb> vbs)
+    /**
+     *  isOval promises that the points trace the ellipse inscribed in their bounds, which
+     *  can't be told apart from a general curved contour by looking at the points alone.
+     */
+    GPath(std::vector<GPoint> pts, std::vector<GPathVerb> vbs, bool isOval = false)
         : fPts(std::move(pts))
         , fVbs(std::move(vbs))
+        , fBounds(this->computeBounds())
+        , fShape(isOval ? GPathShape::kOval : this->computeShape())
     {}
 
 private:
@@ -123,8 +144,13 @@ private:
 
     friend class GPathBuilder;
 
+    GRect computeBounds() const;
+    GPathShape computeShape() const;
+
     const std::vector<GPoint>    fPts;
     const std::vector<GPathVerb> fVbs;
+    const GRect                  fBounds;
+    const GPathShape             fShape;
 };
 
 #endif
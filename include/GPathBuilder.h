@@ -86,6 +86,10 @@ public:
 private:
     std::vector<GPoint>    fPts;
     std::vector<GPathVerb> fVbs;
+
+    // True while the only contour is one added by addCircle, and the builder hasn't been
+    // transformed by anything but a scale and translate since
+    bool                   fIsOval = false;
 };
 
 #endif
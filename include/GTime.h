@@ -8,10 +8,15 @@
 #include "GTypes.h"
 
 using GMSec = unsigned long;
+using GNSec = uint64_t;
 
 class GTime {
 public:
     static GMSec GetMSec();
+
+    /// Nanoseconds from a monotonic clock: only differences between two calls mean anything,
+    /// and they are never thrown off by changes to the wall clock.
+    static GNSec GetNSec();
 };
 
 #endif
@@ -3,6 +3,7 @@
  */
 
 #include "../include/GBitmap.h"
+#include "../SSPremul.h"
 
 void GBitmap::setIsOpaque(IsOpaque io) {
     switch (io) {
@@ -17,17 +18,20 @@ void GBitmap::reset(int w, int h, size_t rb, GPixel* pixels, IsOpaque io) {
     fHeight = h;
     fRowBytes = rb;
     fPixels = pixels;
+    fStorage.reset();
     this->setIsOpaque(io);
     this->validate();
 }
 
+void GBitmap::reset(int w, int h, size_t rb, GPixel* pixels, IsOpaque io, std::shared_ptr<void> storage) {
+    this->reset(w, h, rb, pixels, io);
+    fStorage = std::move(storage);
+}
+
 bool GBitmap::ComputeIsOpaque(const GBitmap& bm) {
     for (int y = 0; y < bm.height(); ++y) {
-        const GPixel* row = bm.getAddr(0, y);
-        for (int x = 0; x < bm.width(); ++x) {
-            if (GPixel_GetA(row[x]) != 0xFF) {
-                return false;
-            }
+        if (!SSPremul_isOpaqueRow(bm.getAddr(0, y), bm.width())) {
+            return false;
         }
     }
     return true;
@@ -43,7 +47,10 @@ void GBitmap::alloc(int w, int h, size_t rb) {
     fHeight = h;
     fRowBytes = rb;
 
-    this->reset(w, h, rb,
-                (w > 0 && h > 0) ? (GPixel*)calloc(h, rb) : nullptr,
-                kNo_IsOpaque);
+    if (w > 0 && h > 0) {
+        GPixel* pixels = (GPixel*)calloc(h, rb);
+        this->reset(w, h, rb, pixels, kNo_IsOpaque, std::shared_ptr<void>(pixels, free));
+    } else {
+        this->reset(w, h, rb, nullptr, kNo_IsOpaque);
+    }
 }
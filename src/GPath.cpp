@@ -4,25 +4,30 @@
 
 #include "../include/GPathBuilder.h"
 #include "../include/GMatrix.h"
+#include "../GMatrix+SSHelpers.h"
 
 void GPathBuilder::reset() {
     fPts.clear();
     fVbs.clear();
+    fIsOval = false;
 }
 
 void GPathBuilder::moveTo(GPoint p) {
+    fIsOval = false;
     fPts.push_back(p);
     fVbs.push_back(GPathVerb::kMove);
 }
 
 void GPathBuilder::lineTo(GPoint p) {
     assert(fVbs.size() > 0);
+    fIsOval = false;
     fPts.push_back(p);
     fVbs.push_back(GPathVerb::kLine);
 }
 
 void GPathBuilder::quadTo(GPoint p1, GPoint p2) {
     assert(fVbs.size() > 0);
+    fIsOval = false;
     fPts.push_back(p1);
     fPts.push_back(p2);
     fVbs.push_back(GPathVerb::kQuad);
@@ -30,6 +35,7 @@ void GPathBuilder::quadTo(GPoint p1, GPoint p2) {
 
 void GPathBuilder::cubicTo(GPoint p1, GPoint p2, GPoint p3) {
     assert(fVbs.size() > 0);
+    fIsOval = false;
     fPts.push_back(p1);
     fPts.push_back(p2);
     fPts.push_back(p3);
@@ -38,10 +44,12 @@ void GPathBuilder::cubicTo(GPoint p1, GPoint p2, GPoint p3) {
 
 void GPathBuilder::transform(const GMatrix& m) {
     m.mapPoints(fPts.data(), fPts.size());
+    // Scales and translates keep an axis-aligned ellipse inscribed in its bounds
+    fIsOval = fIsOval && GMatrix_isScaleTranslate(m);
 }
 
 std::shared_ptr<GPath> GPathBuilder::detach() {
-    auto path = std::make_shared<GPath>(std::move(fPts), std::move(fVbs));
+    auto path = std::make_shared<GPath>(std::move(fPts), std::move(fVbs), fIsOval);
     this->reset();
     return path;
 }
@@ -59,7 +67,8 @@ std::shared_ptr<GPath> GPath::transform(const GMatrix& m) const {
     }
     std::vector<GPoint> dst(fPts.size());
     m.mapPoints(dst.data(), fPts.data(), fPts.size());
-    return std::make_shared<GPath>(std::move(dst), fVbs);
+    bool isOval = fShape == GPathShape::kOval && GMatrix_isScaleTranslate(m);
+    return std::make_shared<GPath>(std::move(dst), fVbs, isOval);
 }
 
 GPath::Iter::Iter(const GPath& path) {
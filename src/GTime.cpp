@@ -5,6 +5,7 @@
 #include "../include/GTime.h"
 
 #include <sys/time.h>
+#include <time.h>
 
 GMSec GTime::GetMSec() {
     struct timeval tv;
@@ -16,3 +17,12 @@ GMSec GTime::GetMSec() {
     }
 }
 
+GNSec GTime::GetNSec() {
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts)) {
+        return 0;
+    } else {
+        return static_cast<GNSec>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+}